@@ -0,0 +1,47 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+#
+# Primitive get_/set_ accessors on Memory, compared with String#unpack1 and
+# String#bytesplice/Array#pack on a binary String and with Fiddle::Pointer.
+#
+
+require 'bench_helper'
+
+include SnowBench
+
+# [type, pack directive, value]
+TYPES = [
+  [:uint8_t,  'C',  200],
+  [:int32_t,  'l',  -123456],
+  [:uint64_t, 'Q',  1 << 40],
+  [:float,    'e',  1.5],
+  [:double,   'E',  2.25]
+]
+
+memory = Snow::Memory.malloc(64)
+string = "\0".b * 64
+pointer = Fiddle::Pointer.malloc(64, Fiddle::RUBY_FREE) if HAS_FIDDLE
+
+TYPES.each { |type, directive, value|
+  getter = :"get_#{type}"
+  setter = :"set_#{type}"
+  size = Snow::CStruct::SIZES.fetch(type)
+  memory.__send__(setter, 8, value)
+  string.bytesplice(8, size, [value].pack(directive))
+  pointer[8, size] = [value].pack(directive) if HAS_FIDDLE
+
+  section "#{type} accessors"
+  report("Memory##{getter}") { memory.__send__(getter, 8) }
+  report("String#unpack1('#{directive}', offset:)") { string.unpack1(directive, offset: 8) }
+  report("Fiddle::Pointer#[] + unpack1") { pointer[8, size].unpack1(directive) } if HAS_FIDDLE
+  report("Memory##{setter}") { memory.__send__(setter, 8, value) }
+  report("String#bytesplice + Array#pack") { string.bytesplice(8, size, [value].pack(directive)) }
+  report("Fiddle::Pointer#[]= + Array#pack") { pointer[8, size] = [value].pack(directive) } if HAS_FIDDLE
+}
+
+section "direct calls (no __send__)"
+report("Memory#get_float") { memory.get_float(8) }
+report("Memory#set_float") { memory.set_float(8, 1.5) }
+report("Memory#get_float_array (16 values)", ops: 16) { memory.get_float_array(0, 16) }
@@ -0,0 +1,124 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'snow-data'
+
+begin
+  require 'fiddle'
+rescue LoadError
+end
+
+
+#
+# A minimal benchmark harness so the benchmarks don't depend on anything
+# outside the standard library. Each report runs its block repeatedly for
+# roughly BENCH_TIME seconds (default 1.0) and prints operations per second
+# and objects allocated per operation.
+#
+# Environment variables:
+#
+# - BENCH_TIME: seconds to spend on each report.
+# - BENCH_MAX_SIZE: largest block size in bytes used by size-scaled benchmarks
+#   (default 1gb). Sizes whose blocks can't be allocated are skipped.
+#
+module SnowBench
+
+  TIME     = Float(ENV.fetch('BENCH_TIME', '1.0'))
+  MAX_SIZE = Integer(ENV.fetch('BENCH_MAX_SIZE', (1 << 30).to_s))
+
+  # Block sizes used by size-scaled benchmarks: 16 bytes to 1gb by powers of 16
+  # (and 1gb itself), limited by BENCH_MAX_SIZE.
+  SIZES = [16, 256, 4096, 65536, 1 << 20, 16 << 20, 256 << 20, 1 << 30].select { |size|
+    size <= MAX_SIZE
+  }
+
+  HAS_FIDDLE = defined?(::Fiddle::Pointer) ? true : false
+
+
+  module_function
+
+  #
+  # Prints a section heading for a group of reports.
+  #
+  def section(title)
+    puts
+    puts title
+    puts '-' * title.length
+  end
+
+
+  #
+  # Runs the block repeatedly and prints its operations per second and
+  # allocations per operation. ops is the number of operations a single call
+  # to the block performs (e.g., for a block that loops over an array).
+  #
+  def report(label, ops: 1, &block)
+    # Warm up and find how many calls fit in about a tenth of the time budget
+    batch = 1
+    loop {
+      elapsed = time_calls(batch, &block)
+      break if elapsed >= TIME / 10 || batch >= (1 << 30)
+      batch *= 2
+    }
+
+    calls = 0
+    elapsed = 0.0
+    GC.start
+    allocated = GC.stat(:total_allocated_objects)
+    while elapsed < TIME
+      elapsed += time_calls(batch, &block)
+      calls += batch
+    end
+    allocated = GC.stat(:total_allocated_objects) - allocated
+
+    total_ops = calls * ops
+    printf("  %-44s %14s ops/s %10.2f allocs/op\n",
+           label, format_rate(total_ops / elapsed), allocated.fdiv(total_ops))
+  end
+
+
+  #
+  # Reports on a block for each size in SIZES, yielding the size to a block
+  # that should return the block to measure (or nil to skip that size).
+  #
+  def report_sizes(label)
+    SIZES.each { |size|
+      body = begin
+        yield(size)
+      rescue NoMemoryError, RangeError => ex
+        puts "  #{label} (#{format_size(size)}): skipped (#{ex.class})"
+        nil
+      end
+      report("#{label} (#{format_size(size)})", &body) if body
+    }
+  end
+
+
+  def time_calls(count) # :nodoc:
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    count.times { yield }
+    Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+  end
+
+
+  def format_rate(rate) # :nodoc:
+    case
+    when rate >= 1e9 then '%.2fG' % (rate / 1e9)
+    when rate >= 1e6 then '%.2fM' % (rate / 1e6)
+    when rate >= 1e3 then '%.2fk' % (rate / 1e3)
+    else '%.2f' % rate
+    end
+  end
+
+
+  def format_size(size) # :nodoc:
+    case
+    when size >= (1 << 30) then "#{size >> 30}gb"
+    when size >= (1 << 20) then "#{size >> 20}mb"
+    when size >= (1 << 10) then "#{size >> 10}kb"
+    else "#{size}b"
+    end
+  end
+
+end # module SnowBench
@@ -0,0 +1,47 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+#
+# Memory allocation, reallocation, and copying at block sizes from 16 bytes
+# up to BENCH_MAX_SIZE (1gb by default), compared with String and
+# Fiddle::Pointer where they have an equivalent.
+#
+
+require 'bench_helper'
+
+include SnowBench
+
+section "Memory.malloc + free!"
+report_sizes("Memory.malloc + free!") { |size|
+  proc { Snow::Memory.malloc(size).free! }
+}
+report_sizes("Fiddle::Pointer.malloc + call_free") { |size|
+  proc { Fiddle::Pointer.malloc(size, Fiddle::RUBY_FREE).call_free }
+} if HAS_FIDDLE
+
+section "Memory#realloc!"
+report_sizes("Memory#realloc! (size <-> size / 2)") { |size|
+  block = Snow::Memory.malloc(size)
+  proc {
+    block.realloc!(size / 2)
+    block.realloc!(size)
+  }
+}
+
+section "Memory#copy!"
+report_sizes("Memory#copy!") { |size|
+  source = Snow::Memory.malloc(size)
+  destination = Snow::Memory.malloc(size)
+  proc { destination.copy!(source, 0, 0, size) }
+}
+report_sizes("String#bytesplice") { |size|
+  source = "\0".b * size
+  destination = "\0".b * size
+  proc { destination.bytesplice(0, size, source) }
+}
+report_sizes("Fiddle::Pointer#[]=") { |size|
+  source = Fiddle::Pointer.malloc(size, Fiddle::RUBY_FREE)
+  destination = Fiddle::Pointer.malloc(size, Fiddle::RUBY_FREE)
+  proc { destination[0, size] = source[0, size] }
+} if HAS_FIDDLE
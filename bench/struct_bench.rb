@@ -0,0 +1,49 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+#
+# CStruct member accessors, nested struct members, and struct array
+# iteration.
+#
+
+require 'bench_helper'
+
+include SnowBench
+
+Vec3   = Snow::CStruct[:BenchVec3, 'x: float; y: float; z: float']
+Vertex = Snow::CStruct[:BenchVertex, 'position: BenchVec3; normal: BenchVec3; color: uint32_t']
+
+ARRAY_LENGTH = 1024
+
+vec = Vec3.new
+vertex = Vertex.new
+vertices = Vertex::Array.new(ARRAY_LENGTH)
+vec3s = Vec3::Array.new(ARRAY_LENGTH)
+
+section "StructBase members"
+report("Vec3#x") { vec.x }
+report("Vec3#x=") { vec.x = 1.0 }
+report("Vec3#get_x(0)") { vec.get_x(0) }
+report("Vec3#to_h") { vec.to_h }
+
+section "nested struct members (CStruct.add_type)"
+report("Vertex#position") { vertex.position }
+report("Vertex#position.x") { vertex.position.x }
+report("Vertex#position = Vec3") { vertex.position = vec }
+report("Vertex#color") { vertex.color }
+
+section "Struct::Array (#{ARRAY_LENGTH} elements)"
+report("Vec3::Array#fetch") { vec3s.fetch(17) }
+report("Vec3::Array#[]") { vec3s[17] }
+report("Vec3::Array#each", ops: ARRAY_LENGTH) { vec3s.each { |v| v } }
+report("Vec3::Array#map!", ops: ARRAY_LENGTH) { vec3s.map! { |v| v } }
+report("Vertex::Array#each", ops: ARRAY_LENGTH) { vertices.each { |v| v } }
+report("Vertex::Array#each + position.x", ops: ARRAY_LENGTH) {
+  vertices.each { |v| v.position.x }
+}
+report("Vec3::Array#member_sum(:x)", ops: ARRAY_LENGTH) { vec3s.member_sum(:x) }
+
+section "struct allocation"
+report("Vec3.new") { Vec3.new }
+report("Vec3::Array.new(#{ARRAY_LENGTH})") { Vec3::Array.new(ARRAY_LENGTH) }
@@ -21,7 +21,7 @@ option_mappings = {
   '-Wbs'                 => OptKVPair[:warn_implicit_size, true],
   '--allow-alloca'       => OptKVPair[:allow_alloca, true],
   '--debug-memory-copy'  => OptKVPair[:debug_memory_copy, true],
-  '--debug-allocations'  => OptKVPair[:debug_allocations, true]
+  '--usdt-probes'        => OptKVPair[:usdt_probes, true]
 }
 
 options = {
@@ -30,7 +30,7 @@ options = {
   :warn_no_bytesize   => false,
   :allow_alloca       => false,
   :debug_memory_copy  => false,
-  :debug_allocations  => false
+  :usdt_probes        => false
 }
 
 ARGV.each {
@@ -56,6 +56,28 @@ $CFLAGS += ' -DSD_ALLOW_ALLOCA' if options[:allow_alloca]
 $CFLAGS += ' -DSD_SD_WARN_ON_IMPLICIT_COPY_SIZE' if options[:warn_implicit_size]
 $CFLAGS += ' -DSD_WARN_ON_NO_BYTESIZE_METHOD' if options[:warn_no_bytesize]
 $CFLAGS += ' -DSD_VERBOSE_COPY_LOG' if options[:debug_memory_copy]
-$CFLAGS += ' -DSD_VERBOSE_MALLOC_LOG' if options[:debug_allocations]
+
+if options[:usdt_probes]
+  if have_header('sys/sdt.h')
+    $CFLAGS += ' -DSD_USDT_PROBES'
+  else
+    $stderr.puts "sys/sdt.h not found, building without USDT probes"
+  end
+end
+
+have_func('rb_gc_adjust_memory_usage', 'ruby.h')
+have_header('ruby/memory_view.h')
+have_header('immintrin.h')
+have_header('sys/mman.h')
+have_func('mmap', 'sys/mman.h')
+have_func('posix_madvise', 'sys/mman.h')
+have_func('madvise', 'sys/mman.h')
+have_func('mremap', 'sys/mman.h')
+have_header('sys/syscall.h')
+have_header('unistd.h')
+have_func('pread', 'unistd.h')
+have_func('pwrite', 'unistd.h')
+have_func('rb_io_descriptor', 'ruby/io.h')
+have_header('pthread.h')
 
 create_makefile('snow-data/snowdata_bindings', 'snow-data/')
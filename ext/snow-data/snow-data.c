@@ -5,25 +5,250 @@
 */
 
 #include "ruby.h"
+#include "ruby/thread.h"
+#ifdef HAVE_RUBY_MEMORY_VIEW_H
+#define SD_HAS_MEMORY_VIEW 1
+#include "ruby/memory_view.h"
+#endif
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#define SD_HAS_FD_IO 1
+#include <errno.h>
+#include <unistd.h>
+#include "ruby/io.h"
+#endif
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(HAVE_POSIX_MADVISE)
+#define SD_HAS_MMAP 1
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(SD_HAS_MMAP) && defined(HAVE_SYS_SYSCALL_H)
+#include <sys/syscall.h>
+#ifdef SYS_mbind
+#define SD_HAS_MBIND 1
+#endif
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#define SD_HAS_PTHREAD 1
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__) && defined(HAVE_IMMINTRIN_H)
+#define SD_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+  USDT probes, compiled in when installed with --usdt-probes and sys/sdt.h is
+  available. All probes use the snow_data provider:
+
+  malloc(address, size, alignment)
+  free(address, size, alignment)
+  realloc(old_address, new_address, old_size, new_size, alignment, class_name)
+  copy(destination, source, size, class_name)
+
+  Every probe has a semaphore (sdt.h requires one for each probe once any of
+  them use one), but only realloc and copy check theirs, so their class names
+  are only looked up while a tracer is attached to them.
+ */
+#if defined(SD_USDT_PROBES) && defined(HAVE_SYS_SDT_H)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define SD_PROBE_SEMAPHORE(NAME) \
+  __extension__ unsigned short snow_data_##NAME##_semaphore \
+    __attribute__((unused)) __attribute__((section(".probes")))
+SD_PROBE_SEMAPHORE(malloc);
+SD_PROBE_SEMAPHORE(free);
+SD_PROBE_SEMAPHORE(realloc);
+SD_PROBE_SEMAPHORE(copy);
+#define SD_PROBE_ENABLED(NAME)  (snow_data_##NAME##_semaphore != 0)
+#define SD_PROBE3(NAME, A, B, C)             DTRACE_PROBE3(snow_data, NAME, A, B, C)
+#define SD_PROBE4(NAME, A, B, C, D)          DTRACE_PROBE4(snow_data, NAME, A, B, C, D)
+#define SD_PROBE6(NAME, A, B, C, D, E, F)    DTRACE_PROBE6(snow_data, NAME, A, B, C, D, E, F)
+#else
+#define SD_PROBE_ENABLED(NAME)  0
+#define SD_PROBE3(NAME, A, B, C)
+#define SD_PROBE4(NAME, A, B, C, D)
+#define SD_PROBE6(NAME, A, B, C, D, E, F)
+#endif
+
+#ifndef RUBY_TYPED_FREE_IMMEDIATELY
+#define RUBY_TYPED_FREE_IMMEDIATELY 0
+#endif
 
 typedef enum e_sd_free_memory_flag {
   SD_DO_NOT_FREE_MEMORY = 0,
   SD_FREE_MEMORY        = 1
 } sd_free_memory_flag_t;
 
-static ID kSD_IVAR_BYTESIZE;
-static ID kSD_IVAR_ALIGNMENT;
+typedef enum e_sd_zero_memory_flag {
+  SD_DO_NOT_ZERO_MEMORY = 0,
+  SD_ZERO_MEMORY        = 1
+} sd_zero_memory_flag_t;
+
+/*
+  The native side of a Memory object. Every Memory object wraps exactly one of
+  these, so the block's size and alignment can be read without going through
+  instance variables. free_func is NULL if the object doesn't own the block or
+  if the block is a slot in a pool, in which case pool is set instead.
+ */
+typedef struct s_sd_memory {
+  void   *data;
+  size_t bytesize;
+  size_t alignment;
+  void   (*free_func)(void *data, size_t bytesize, size_t alignment);
+  /* Member layout of the object's struct class, looked up on first access */
+  const struct s_sd_layout *layout;
+  /* Object the block belongs to, if any (e.g., an Arena), kept alive while
+     this object is */
+  VALUE  owner;
+  /* Pool the block was allocated from, if it's a pool slot */
+  struct s_sd_pool *pool;
+  /* Number of String views and MemoryViews of the block and IO calls in
+     progress on it. The block can't be freed or reallocated while this is
+     nonzero. String views release their pin when they're collected */
+  size_t pinned;
+  /* Per-class stats the block is counted in, if any */
+  struct s_sd_class_stats *class_stats;
+  /* Shared with the pins held by String views of the block, if any */
+  struct s_sd_view_pins *view_pins;
+  /* Set for blocks mapped read-only and the struct wrappers into them, whose
+     pages would fault if written to */
+  bool   readonly;
+} sd_memory_t;
+
+/*
+  Links a Memory object to the pins its String views hold. The views and the
+  object may be collected in the same GC pass in either order, so neither
+  frees this while the other still refers to it: block is cleared when the
+  object is freed, and the record is freed by whichever of the two goes last.
+ */
+typedef struct s_sd_view_pins {
+  sd_memory_t *block;
+  size_t      count;
+} sd_view_pins_t;
+
+/*
+  Types a struct member may have. SD_TYPE_STRUCT covers any Memory subclass
+  added as a type through CStruct::add_type.
+ */
+typedef enum e_sd_type {
+  SD_TYPE_STRUCT = 0,
+  SD_TYPE_INT8_T,
+  SD_TYPE_INT16_T,
+  SD_TYPE_INT32_T,
+  SD_TYPE_INT64_T,
+  SD_TYPE_UINT8_T,
+  SD_TYPE_UINT16_T,
+  SD_TYPE_UINT32_T,
+  SD_TYPE_UINT64_T,
+  SD_TYPE_SIZE_T,
+  SD_TYPE_PTRDIFF_T,
+  SD_TYPE_INTPTR_T,
+  SD_TYPE_UINTPTR_T,
+  SD_TYPE_LONG,
+  SD_TYPE_LONG_LONG,
+  SD_TYPE_UNSIGNED_LONG,
+  SD_TYPE_UNSIGNED_LONG_LONG,
+  SD_TYPE_FLOAT,
+  SD_TYPE_DOUBLE,
+  SD_TYPE_INT,
+  SD_TYPE_UNSIGNED_INT,
+  SD_TYPE_SHORT,
+  SD_TYPE_UNSIGNED_SHORT,
+  SD_TYPE_CHAR,
+  SD_TYPE_UNSIGNED_CHAR,
+  SD_TYPE_SIGNED_CHAR
+} sd_type_t;
+
+typedef struct s_sd_type_info {
+  const char *name;
+  sd_type_t  type;
+  size_t     size;
+} sd_type_info_t;
+
+/* Primitive types by their CStruct names. */
+static const sd_type_info_t sd_type_infos[] = {
+  { "int8_t",             SD_TYPE_INT8_T,             sizeof(int8_t) },
+  { "int16_t",            SD_TYPE_INT16_T,            sizeof(int16_t) },
+  { "int32_t",            SD_TYPE_INT32_T,            sizeof(int32_t) },
+  { "int64_t",            SD_TYPE_INT64_T,            sizeof(int64_t) },
+  { "uint8_t",            SD_TYPE_UINT8_T,            sizeof(uint8_t) },
+  { "uint16_t",           SD_TYPE_UINT16_T,           sizeof(uint16_t) },
+  { "uint32_t",           SD_TYPE_UINT32_T,           sizeof(uint32_t) },
+  { "uint64_t",           SD_TYPE_UINT64_T,           sizeof(uint64_t) },
+  { "size_t",             SD_TYPE_SIZE_T,             sizeof(size_t) },
+  { "ptrdiff_t",          SD_TYPE_PTRDIFF_T,          sizeof(ptrdiff_t) },
+  { "intptr_t",           SD_TYPE_INTPTR_T,           sizeof(intptr_t) },
+  { "uintptr_t",          SD_TYPE_UINTPTR_T,          sizeof(uintptr_t) },
+  { "long",               SD_TYPE_LONG,               sizeof(long) },
+  { "long_long",          SD_TYPE_LONG_LONG,          sizeof(long long) },
+  { "unsigned_long",      SD_TYPE_UNSIGNED_LONG,      sizeof(unsigned long) },
+  { "unsigned_long_long", SD_TYPE_UNSIGNED_LONG_LONG, sizeof(unsigned long long) },
+  { "float",              SD_TYPE_FLOAT,              sizeof(float) },
+  { "double",             SD_TYPE_DOUBLE,             sizeof(double) },
+  { "int",                SD_TYPE_INT,                sizeof(int) },
+  { "unsigned_int",       SD_TYPE_UNSIGNED_INT,       sizeof(unsigned int) },
+  { "short",              SD_TYPE_SHORT,              sizeof(short) },
+  { "unsigned_short",     SD_TYPE_UNSIGNED_SHORT,     sizeof(unsigned short) },
+  { "char",               SD_TYPE_CHAR,               sizeof(char) },
+  { "unsigned_char",      SD_TYPE_UNSIGNED_CHAR,      sizeof(unsigned char) },
+  { "signed_char",        SD_TYPE_SIGNED_CHAR,        sizeof(signed char) },
+  { NULL,                 SD_TYPE_STRUCT,             0 }
+};
+
+/*
+  Describes a single struct member: where it is, what type it is, and how many
+  elements long it is. klass is the member's Memory subclass for struct types
+  and Qnil otherwise.
+ */
+typedef struct s_sd_member {
+  ID        name;
+  ID        getter;
+  ID        setter;
+  sd_type_t type;
+  size_t    offset;
+  size_t    type_size;
+  size_t    type_alignment;
+  size_t    length;
+  VALUE     klass;
+} sd_member_t;
+
+/*
+  The members of a struct class, plus an index from getter and setter method
+  IDs to members.
+ */
+typedef struct s_sd_layout {
+  sd_member_t *members;
+  size_t      count;
+  size_t      capacity;
+  st_table    *method_index;
+} sd_layout_t;
+
 static ID kSD_ID_BYTESIZE;
 static ID kSD_ID_ADDRESS;
+static ID kSD_ID_LAYOUT;
+static ID kSD_IVAR_BASE_MEMORY;
+static ID kSD_IVAR_VIEW_ROOT;
+static ID kSD_ID_TRACK_VIEW;
 
 #define SD_INT8_TO_NUM(X)                 INT2FIX(X)
 #define SD_INT16_TO_NUM(X)                INT2FIX(X)
 #define SD_INT32_TO_NUM(X)                INT2FIX(X)
-#define SD_NUM_TO_INT8(X)                 ((int8_t)INT2FIX(X))
-#define SD_NUM_TO_INT16(X)                ((int16_t)INT2FIX(X))
-#define SD_NUM_TO_INT32(X)                ((int32_t)INT2FIX(X))
+#define SD_NUM_TO_INT8(X)                 ((int8_t)NUM2INT(X))
+#define SD_NUM_TO_INT16(X)                ((int16_t)NUM2INT(X))
+#define SD_NUM_TO_INT32(X)                ((int32_t)NUM2INT(X))
 
 #if INT64_MAX <= INT_MAX
 #define SD_INT64_TO_NUM(X)                INT2FIX(X)
@@ -130,16 +355,49 @@ static ID kSD_ID_ADDRESS;
 #define SD_NUM_TO_UNSIGNED_CHAR(X)        ((unsigned char)NUM2UINT(X))
 #define SD_NUM_TO_SIGNED_CHAR(X)          ((signed char)NUM2INT(X))
 
-static void sd_check_null_block(VALUE self)
+static void sd_memory_dmark(void *ptr);
+static void sd_memory_dfree(void *ptr);
+static size_t sd_memory_dsize(const void *ptr);
+
+static const rb_data_type_t sd_memory_type = {
+  "Snow::Memory",
+  { sd_memory_dmark, sd_memory_dfree, sd_memory_dsize, },
+  0, 0,
+  RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+  Returns the sd_memory_t for a Memory object. Memory and all its subclasses
+  use sd_memory_alloc as their allocator, so any receiver of a Memory method is
+  guaranteed to have one and no type check is done here.
+ */
+static sd_memory_t *sd_memory_get(VALUE self)
+{
+  return (sd_memory_t *)RTYPEDDATA_DATA(self);
+}
+
+static void sd_check_null_block(const sd_memory_t *block)
 {
-  if (DATA_PTR(self) == NULL) {
+  if (block->data == NULL) {
     rb_raise(rb_eRuntimeError, "Pointer is NULL");
   }
 }
 
-static void sd_check_block_bounds(VALUE self, size_t offset, size_t size)
+/*
+  Raises if self can't be written to, either because it's frozen or because its
+  block is read-only.
+ */
+static void sd_check_writable(VALUE self, const sd_memory_t *block)
+{
+  rb_check_frozen(self);
+  if (block->readonly) {
+    rb_raise(rb_eRuntimeError, "Cannot write to read-only %s", rb_obj_classname(self));
+  }
+}
+
+static void sd_check_block_bounds(const sd_memory_t *block, size_t offset, size_t size)
 {
-  const size_t block_size = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE));
+  const size_t block_size = block->bytesize;
   if (offset >= block_size) {
     rb_raise(rb_eRangeError,
       "Offset %zu is out of bounds for block with size %zu",
@@ -151,6 +409,48 @@ static void sd_check_block_bounds(VALUE self, size_t offset, size_t size)
   }
 }
 
+/*
+  Raises a RangeError if any of count values of the given size, the first at
+  offset and each following one stride bytes after the last, falls outside the
+  block. A count of zero is always in bounds.
+ */
+static void sd_check_block_range(const sd_memory_t *block, size_t offset, size_t count, size_t stride, size_t size)
+{
+  size_t last_offset;
+
+  if (count == 0) {
+    return;
+  }
+
+  last_offset = offset + (count - 1) * stride;
+  if ((count - 1) > (~(size_t)0 - offset) / stride || last_offset < offset) {
+    rb_raise(rb_eRangeError,
+      "Range of %zu values with stride %zu at offset %zu is too large",
+      count, stride, offset);
+  }
+
+  sd_check_block_bounds(block, offset, size);
+  sd_check_block_bounds(block, last_offset, size);
+}
+
+/*
+  Returns the stride given to a bulk accessor, or the default stride if it's
+  nil. Raises an ArgumentError if the stride is zero.
+ */
+static size_t sd_get_stride(VALUE sd_stride, size_t default_stride)
+{
+  size_t stride = default_stride;
+
+  if (RTEST(sd_stride)) {
+    stride = NUM2SIZET(sd_stride);
+    if (stride == 0) {
+      rb_raise(rb_eArgError, "Stride must be 1 or greater");
+    }
+  }
+
+  return stride;
+}
+
 /*
   Returns 1 if size is a power of two and nonzero, otherwise returns 0.
  */
@@ -177,18 +477,294 @@ static void *align_ptr(void *ptr, size_t alignment)
   return (void *)(((intptr_t)ptr + (alignment - 1)) & ~(alignment - 1));
 }
 
+/*
+  Tells the GC that diff bytes of native memory were allocated (or freed, if
+  negative) outside of its own malloc functions. Does nothing on Rubies without
+  rb_gc_adjust_memory_usage.
+ */
+static void sd_gc_adjust_memory_usage(ssize_t diff)
+{
+  #ifdef HAVE_RB_GC_ADJUST_MEMORY_USAGE
+  rb_gc_adjust_memory_usage(diff);
+  #else
+  (void)diff;
+  #endif
+}
+
+/*
+  Allocation statistics. sd_stats counts every block allocated by com_malloc,
+  including pool slabs and arena chunks, along with reallocs and bytes copied
+  by copy!. Byte counts are of requested sizes, not including alignment
+  padding. These are only touched while holding the GVL.
+ */
+typedef struct s_sd_stats {
+  size_t live_blocks;
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t total_allocs;
+  size_t total_frees;
+  size_t reallocs;
+  size_t bytes_copied;
+} sd_stats_t;
+
+static sd_stats_t sd_stats;
+
+/*
+  Per-class statistics for blocks owned by Memory objects (allocated with
+  malloc, realloc!, or from a pool), only kept while
+  Memory.track_class_stats is true. Records are keyed by class in
+  sd_class_stats_table and never freed.
+ */
+typedef struct s_sd_class_stats {
+  size_t live_blocks;
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t total_allocs;
+  size_t total_frees;
+} sd_class_stats_t;
+
+static int sd_track_class_stats = 0;
+static st_table *sd_class_stats_table = NULL;
+
+static void sd_stats_allocated(size_t size)
+{
+  sd_stats.live_blocks  += 1;
+  sd_stats.total_allocs += 1;
+  sd_stats.live_bytes   += size;
+  if (sd_stats.live_bytes > sd_stats.peak_bytes) {
+    sd_stats.peak_bytes = sd_stats.live_bytes;
+  }
+}
+
+static void sd_stats_freed(size_t size)
+{
+  sd_stats.live_blocks  -= 1;
+  sd_stats.total_frees  += 1;
+  sd_stats.live_bytes   -= size;
+}
+
+/*
+  Records that a Memory object of the given class now owns its block, if
+  per-class stats are being kept. Classes seen this way are never collected.
+ */
+static void sd_class_stats_own(VALUE klass, sd_memory_t *block)
+{
+  st_data_t record;
+  sd_class_stats_t *stats;
+
+  if (!sd_track_class_stats) {
+    return;
+  }
+
+  if (!st_lookup(sd_class_stats_table, (st_data_t)klass, &record)) {
+    record = (st_data_t)ZALLOC(sd_class_stats_t);
+    st_insert(sd_class_stats_table, (st_data_t)klass, record);
+    rb_gc_register_mark_object(klass);
+  }
+
+  stats = (sd_class_stats_t *)record;
+  stats->live_blocks  += 1;
+  stats->total_allocs += 1;
+  stats->live_bytes   += block->bytesize;
+  if (stats->live_bytes > stats->peak_bytes) {
+    stats->peak_bytes = stats->live_bytes;
+  }
+  block->class_stats = stats;
+}
+
+/*
+  Records that a block counted by sd_class_stats_own was freed or released.
+ */
+static void sd_class_stats_release(sd_memory_t *block)
+{
+  sd_class_stats_t *const stats = block->class_stats;
+
+  if (stats) {
+    stats->live_blocks  -= 1;
+    stats->total_frees  += 1;
+    stats->live_bytes   -= block->bytesize;
+    block->class_stats = NULL;
+  }
+}
+
+/*
+  Records that a block was resized in place from old_size to new_size bytes.
+  Must be called before the block's bytesize is updated.
+ */
+static void sd_stats_resized(sd_memory_t *block, size_t old_size, size_t new_size)
+{
+  sd_class_stats_t *const stats = block->class_stats;
+
+  sd_stats.live_bytes = sd_stats.live_bytes - old_size + new_size;
+  if (sd_stats.live_bytes > sd_stats.peak_bytes) {
+    sd_stats.peak_bytes = sd_stats.live_bytes;
+  }
+
+  if (stats) {
+    stats->live_bytes = stats->live_bytes - old_size + new_size;
+    if (stats->live_bytes > stats->peak_bytes) {
+      stats->peak_bytes = stats->live_bytes;
+    }
+  }
+}
+
+static VALUE sd_class_stats_to_hash(const sd_class_stats_t *stats)
+{
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("live_blocks")), SIZET2NUM(stats->live_blocks));
+  rb_hash_aset(hash, ID2SYM(rb_intern("live_bytes")), SIZET2NUM(stats->live_bytes));
+  rb_hash_aset(hash, ID2SYM(rb_intern("peak_bytes")), SIZET2NUM(stats->peak_bytes));
+  rb_hash_aset(hash, ID2SYM(rb_intern("total_allocs")), SIZET2NUM(stats->total_allocs));
+  rb_hash_aset(hash, ID2SYM(rb_intern("total_frees")), SIZET2NUM(stats->total_frees));
+  return hash;
+}
+
+/*
+  call-seq:
+      stats => Hash
+
+  Returns a Hash of statistics for all native memory allocated by snow-data,
+  including pool slabs, arena chunks, and blocks mapped by malloc but not
+  memory-mapped files:
+
+  [:live_blocks]  The number of blocks currently allocated.
+  [:live_bytes]   The total size in bytes of those blocks.
+  [:peak_bytes]   The largest live_bytes has been (since ::reset_stats!).
+  [:total_allocs] The number of blocks ever allocated.
+  [:total_frees]  The number of blocks ever freed.
+  [:reallocs]     The number of calls to realloc! that resized the block.
+  [:bytes_copied] The number of bytes copied by copy!.
+
+  Sizes are those requested, not counting alignment padding. Keeping these is
+  always on and costs a few additions per allocation.
+ */
+static VALUE sd_memory_stats(VALUE self)
+{
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("live_blocks")), SIZET2NUM(sd_stats.live_blocks));
+  rb_hash_aset(hash, ID2SYM(rb_intern("live_bytes")), SIZET2NUM(sd_stats.live_bytes));
+  rb_hash_aset(hash, ID2SYM(rb_intern("peak_bytes")), SIZET2NUM(sd_stats.peak_bytes));
+  rb_hash_aset(hash, ID2SYM(rb_intern("total_allocs")), SIZET2NUM(sd_stats.total_allocs));
+  rb_hash_aset(hash, ID2SYM(rb_intern("total_frees")), SIZET2NUM(sd_stats.total_frees));
+  rb_hash_aset(hash, ID2SYM(rb_intern("reallocs")), SIZET2NUM(sd_stats.reallocs));
+  rb_hash_aset(hash, ID2SYM(rb_intern("bytes_copied")), SIZET2NUM(sd_stats.bytes_copied));
+  return hash;
+}
+
+static int sd_class_stats_each(st_data_t key, st_data_t value, st_data_t arg)
+{
+  rb_hash_aset((VALUE)arg, (VALUE)key, sd_class_stats_to_hash((const sd_class_stats_t *)value));
+  return ST_CONTINUE;
+}
+
+static int sd_class_stats_reset_each(st_data_t key, st_data_t value, st_data_t arg)
+{
+  sd_class_stats_t *const stats = (sd_class_stats_t *)value;
+  stats->peak_bytes   = stats->live_bytes;
+  stats->total_allocs = 0;
+  stats->total_frees  = 0;
+  return ST_CONTINUE;
+}
+
+/*
+  call-seq:
+      class_stats => Hash
+
+  Returns a Hash of Memory classes to statistics for the blocks owned by
+  objects of each class, counted while ::track_class_stats was true. Each
+  class's statistics are a Hash with the :live_blocks, :live_bytes,
+  :peak_bytes, :total_allocs, and :total_frees keys described in ::stats.
+
+  Only blocks allocated by malloc, realloc!, or a Snow::Pool are counted. A
+  block is counted under the class of the object that allocated it, so a
+  struct class whose live_bytes keeps growing is leaking blocks.
+ */
+static VALUE sd_memory_class_stats(VALUE self)
+{
+  VALUE hash = rb_hash_new();
+  st_foreach(sd_class_stats_table, sd_class_stats_each, (st_data_t)hash);
+  return hash;
+}
+
+/*
+  call-seq:
+      reset_stats! => self
+
+  Resets the allocation, free, realloc, and copy totals in ::stats and
+  ::class_stats to zero, and their peak byte counts to the current live byte
+  counts. Live counts are left alone.
+ */
+static VALUE sd_memory_reset_stats(VALUE self)
+{
+  sd_stats.peak_bytes   = sd_stats.live_bytes;
+  sd_stats.total_allocs = 0;
+  sd_stats.total_frees  = 0;
+  sd_stats.reallocs     = 0;
+  sd_stats.bytes_copied = 0;
+  st_foreach(sd_class_stats_table, sd_class_stats_reset_each, 0);
+  return self;
+}
+
+/*
+  call-seq:
+      track_class_stats => true or false
+
+  Returns whether per-class statistics are being kept (see ::class_stats).
+  Defaults to false.
+ */
+static VALUE sd_memory_get_track_class_stats(VALUE self)
+{
+  return sd_track_class_stats ? Qtrue : Qfalse;
+}
+
+/*
+  call-seq:
+      track_class_stats = enabled => enabled
+
+  Turns keeping per-class statistics on or off. Only blocks allocated while
+  this is on are counted, but blocks that were counted are still counted as
+  freed after turning it off. Every class counted is kept alive for the rest
+  of the process, so avoid turning this on in programs that create many
+  anonymous struct classes.
+ */
+static VALUE sd_memory_set_track_class_stats(VALUE self, VALUE sd_enabled)
+{
+  sd_track_class_stats = RTEST(sd_enabled);
+  return sd_enabled;
+}
+
+/*
+  Returns the number of bytes com_malloc really allocates for a block of the
+  given size and alignment, including the space for the underlying pointer and
+  any padding needed to align the block.
+ */
+static size_t com_alloc_size(size_t size, size_t alignment)
+{
+  return size + sizeof(void *) + (alignment - 1);
+}
+
 /*
   Allocated a block of memory of at least size bytes aligned to the given byte
-  alignment.
+  alignment. The allocation is reported to the GC as malloc pressure, so
+  com_free must be given the same size and alignment to undo it. The block is
+  zeroed only if zero is SD_ZERO_MEMORY.
+
+  If the first attempt to allocate fails, the GC is run and it tries again
+  before giving up.
 
   Raises a NoMemoryError if it's not possible to allocate memory.
  */
-static void *com_malloc(size_t size, size_t alignment)
+static void *com_malloc(size_t size, size_t alignment, sd_zero_memory_flag_t zero)
 {
-  const size_t aligned_size = align_size(size + sizeof(void *), alignment);
-  void *const ptr = xcalloc(aligned_size, 1);
+  const size_t aligned_size = com_alloc_size(size, alignment);
+  void *ptr = zero ? calloc(aligned_size, 1) : malloc(aligned_size);
   void **aligned_ptr;
 
+  if (!ptr) {
+    rb_gc();
+    ptr = zero ? calloc(aligned_size, 1) : malloc(aligned_size);
+  }
+
   if (!ptr) {
     rb_raise(rb_eNoMemError,
       "Failed to allocate %zu (req: %zu) bytes via malloc",
@@ -199,36 +775,76 @@ static void *com_malloc(size_t size, size_t alignment)
   aligned_ptr = align_ptr((uint8_t *)ptr + sizeof(void *), alignment);
   aligned_ptr[-1] = ptr;
 
-  #ifdef SD_VERBOSE_MALLOC_LOG
-  fprintf(stderr, "Allocated block %p with aligned size %zu (requested: %zu"
-    " aligned to %zu bytes), returning aligned pointer %p with usable size %td\n",
-    ptr, aligned_size, size, alignment, aligned_ptr,
-    (uint8_t *)(ptr + aligned_size) - (uint8_t *)aligned_ptr);
-  #endif
+  sd_gc_adjust_memory_usage((ssize_t)aligned_size);
+  sd_stats_allocated(size);
+  SD_PROBE3(malloc, aligned_ptr, size, alignment);
 
   return aligned_ptr;
 }
 
 /*
   Frees memory previously allocated by com_malloc. This _does not work_ if it
-  was allocated by any other means.
+  was allocated by any other means. The size and alignment must be those the
+  block was allocated with.
 
   Raises a RuntimeError if aligned_ptr is NULL.
  */
-static void com_free(void *aligned_ptr)
+static void com_free(void *aligned_ptr, size_t size, size_t alignment)
 {
   if (!aligned_ptr) {
     rb_raise(rb_eRuntimeError, "Attempt to call free on NULL");
     return;
   }
 
-  #ifdef SD_VERBOSE_MALLOC_LOG
-  fprintf(stderr, "Deallocating aligned pointer %p with underlying pointer %p\n",
-    aligned_ptr,
-    ((void **)aligned_ptr)[-1]);
-  #endif
+  SD_PROBE3(free, aligned_ptr, size, alignment);
+  free(((void **)aligned_ptr)[-1]);
+  sd_gc_adjust_memory_usage(-(ssize_t)com_alloc_size(size, alignment));
+  sd_stats_freed(size);
+}
+
+/*
+  Resizes a block allocated by com_malloc using the C library's realloc, which
+  can often grow or shrink the block without moving it (and, in glibc, uses
+  mremap for large blocks allocated by mmap instead of copying them). If the
+  block does move, its contents are moved to keep the same alignment. New bytes
+  are not zeroed. The alignment must be the one the block was allocated with.
+
+  If the first attempt to reallocate fails, the GC is run and it tries again
+  before giving up. Raises a NoMemoryError if that fails too, in which case the
+  original block is left as it was.
+ */
+static void *com_realloc(void *aligned_ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+  const size_t old_aligned_size = com_alloc_size(old_size, alignment);
+  const size_t new_aligned_size = com_alloc_size(new_size, alignment);
+  void *const old_ptr = ((void **)aligned_ptr)[-1];
+  const size_t old_offset = (size_t)((uint8_t *)aligned_ptr - (uint8_t *)old_ptr);
+  void *ptr = realloc(old_ptr, new_aligned_size);
+  void **new_aligned_ptr;
+
+  if (!ptr) {
+    rb_gc();
+    ptr = realloc(old_ptr, new_aligned_size);
+  }
+
+  if (!ptr) {
+    rb_raise(rb_eNoMemError,
+      "Failed to reallocate %zu (req: %zu) bytes via realloc",
+      new_aligned_size, new_size);
+    return NULL;
+  }
+
+  new_aligned_ptr = align_ptr((uint8_t *)ptr + sizeof(void *), alignment);
+  if ((uint8_t *)new_aligned_ptr != (uint8_t *)ptr + old_offset) {
+    /* The block moved and its old offset isn't aligned in the new one */
+    const size_t copy_sizes[2] = { old_size, new_size };
+    memmove(new_aligned_ptr, (uint8_t *)ptr + old_offset, copy_sizes[old_size > new_size]);
+  }
+  new_aligned_ptr[-1] = ptr;
+
+  sd_gc_adjust_memory_usage((ssize_t)new_aligned_size - (ssize_t)old_aligned_size);
 
-  xfree(((void **)aligned_ptr)[-1]);
+  return new_aligned_ptr;
 }
 
 /*
@@ -244,10 +860,11 @@ static VALUE sd_get_int8(VALUE self, VALUE sd_offset)
 {
   typedef int8_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INT8_TO_NUM(value);
 }
 
@@ -261,12 +878,13 @@ static VALUE sd_set_int8(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef int8_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INT8(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -283,10 +901,11 @@ static VALUE sd_get_int16(VALUE self, VALUE sd_offset)
 {
   typedef int16_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INT16_TO_NUM(value);
 }
 
@@ -300,12 +919,13 @@ static VALUE sd_set_int16(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef int16_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INT16(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -322,10 +942,11 @@ static VALUE sd_get_int32(VALUE self, VALUE sd_offset)
 {
   typedef int32_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INT32_TO_NUM(value);
 }
 
@@ -339,12 +960,13 @@ static VALUE sd_set_int32(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef int32_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INT32(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -361,10 +983,11 @@ static VALUE sd_get_int64(VALUE self, VALUE sd_offset)
 {
   typedef int64_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INT64_TO_NUM(value);
 }
 
@@ -378,12 +1001,13 @@ static VALUE sd_set_int64(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef int64_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INT64(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -400,10 +1024,11 @@ static VALUE sd_get_uint8(VALUE self, VALUE sd_offset)
 {
   typedef uint8_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UINT8_TO_NUM(value);
 }
 
@@ -417,12 +1042,13 @@ static VALUE sd_set_uint8(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef uint8_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UINT8(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -439,10 +1065,11 @@ static VALUE sd_get_uint16(VALUE self, VALUE sd_offset)
 {
   typedef uint16_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UINT16_TO_NUM(value);
 }
 
@@ -456,12 +1083,13 @@ static VALUE sd_set_uint16(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef uint16_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UINT16(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -478,10 +1106,11 @@ static VALUE sd_get_uint32(VALUE self, VALUE sd_offset)
 {
   typedef uint32_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UINT32_TO_NUM(value);
 }
 
@@ -495,12 +1124,13 @@ static VALUE sd_set_uint32(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef uint32_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UINT32(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -517,10 +1147,11 @@ static VALUE sd_get_uint64(VALUE self, VALUE sd_offset)
 {
   typedef uint64_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UINT64_TO_NUM(value);
 }
 
@@ -534,12 +1165,13 @@ static VALUE sd_set_uint64(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef uint64_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UINT64(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -556,10 +1188,11 @@ static VALUE sd_get_size_t(VALUE self, VALUE sd_offset)
 {
   typedef size_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_SIZE_T_TO_NUM(value);
 }
 
@@ -573,12 +1206,13 @@ static VALUE sd_set_size_t(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef size_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_SIZE_T(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -595,10 +1229,11 @@ static VALUE sd_get_ptrdiff_t(VALUE self, VALUE sd_offset)
 {
   typedef ptrdiff_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_PTRDIFF_T_TO_NUM(value);
 }
 
@@ -612,12 +1247,13 @@ static VALUE sd_set_ptrdiff_t(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef ptrdiff_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_PTRDIFF_T(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -634,10 +1270,11 @@ static VALUE sd_get_intptr_t(VALUE self, VALUE sd_offset)
 {
   typedef intptr_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INTPTR_T_TO_NUM(value);
 }
 
@@ -651,12 +1288,13 @@ static VALUE sd_set_intptr_t(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef intptr_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INTPTR_T(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -673,10 +1311,11 @@ static VALUE sd_get_uintptr_t(VALUE self, VALUE sd_offset)
 {
   typedef uintptr_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UINTPTR_T_TO_NUM(value);
 }
 
@@ -690,12 +1329,13 @@ static VALUE sd_set_uintptr_t(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef uintptr_t conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UINTPTR_T(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -712,10 +1352,11 @@ static VALUE sd_get_long(VALUE self, VALUE sd_offset)
 {
   typedef long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_LONG_TO_NUM(value);
 }
 
@@ -729,12 +1370,13 @@ static VALUE sd_set_long(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_LONG(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -751,10 +1393,11 @@ static VALUE sd_get_long_long(VALUE self, VALUE sd_offset)
 {
   typedef long long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_LONG_LONG_TO_NUM(value);
 }
 
@@ -768,12 +1411,13 @@ static VALUE sd_set_long_long(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef long long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_LONG_LONG(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -790,10 +1434,11 @@ static VALUE sd_get_unsigned_long(VALUE self, VALUE sd_offset)
 {
   typedef unsigned long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UNSIGNED_LONG_TO_NUM(value);
 }
 
@@ -807,12 +1452,13 @@ static VALUE sd_set_unsigned_long(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef unsigned long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UNSIGNED_LONG(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -829,10 +1475,11 @@ static VALUE sd_get_unsigned_long_long(VALUE self, VALUE sd_offset)
 {
   typedef unsigned long long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UNSIGNED_LONG_LONG_TO_NUM(value);
 }
 
@@ -846,12 +1493,13 @@ static VALUE sd_set_unsigned_long_long(VALUE self, VALUE sd_offset, VALUE sd_val
 {
   typedef unsigned long long conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UNSIGNED_LONG_LONG(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -868,10 +1516,11 @@ static VALUE sd_get_float(VALUE self, VALUE sd_offset)
 {
   typedef float conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_FLOAT_TO_NUM(value);
 }
 
@@ -885,12 +1534,13 @@ static VALUE sd_set_float(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef float conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_FLOAT(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -907,10 +1557,11 @@ static VALUE sd_get_double(VALUE self, VALUE sd_offset)
 {
   typedef double conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_DOUBLE_TO_NUM(value);
 }
 
@@ -924,12 +1575,13 @@ static VALUE sd_set_double(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef double conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_DOUBLE(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -946,10 +1598,11 @@ static VALUE sd_get_int(VALUE self, VALUE sd_offset)
 {
   typedef int conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_INT_TO_NUM(value);
 }
 
@@ -963,12 +1616,13 @@ static VALUE sd_set_int(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef int conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_INT(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -985,10 +1639,11 @@ static VALUE sd_get_unsigned_int(VALUE self, VALUE sd_offset)
 {
   typedef unsigned int conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UNSIGNED_INT_TO_NUM(value);
 }
 
@@ -1002,12 +1657,13 @@ static VALUE sd_set_unsigned_int(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef unsigned int conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UNSIGNED_INT(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -1024,10 +1680,11 @@ static VALUE sd_get_short(VALUE self, VALUE sd_offset)
 {
   typedef short conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_SHORT_TO_NUM(value);
 }
 
@@ -1041,12 +1698,13 @@ static VALUE sd_set_short(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef short conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_SHORT(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -1063,10 +1721,11 @@ static VALUE sd_get_unsigned_short(VALUE self, VALUE sd_offset)
 {
   typedef unsigned short conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UNSIGNED_SHORT_TO_NUM(value);
 }
 
@@ -1080,12 +1739,13 @@ static VALUE sd_set_unsigned_short(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef unsigned short conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UNSIGNED_SHORT(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -1102,10 +1762,11 @@ static VALUE sd_get_char(VALUE self, VALUE sd_offset)
 {
   typedef char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_CHAR_TO_NUM(value);
 }
 
@@ -1119,12 +1780,13 @@ static VALUE sd_set_char(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_CHAR(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -1141,10 +1803,11 @@ static VALUE sd_get_unsigned_char(VALUE self, VALUE sd_offset)
 {
   typedef unsigned char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_UNSIGNED_CHAR_TO_NUM(value);
 }
 
@@ -1158,12 +1821,13 @@ static VALUE sd_set_unsigned_char(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef unsigned char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_UNSIGNED_CHAR(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
@@ -1180,10 +1844,11 @@ static VALUE sd_get_signed_char(VALUE self, VALUE sd_offset)
 {
   typedef signed char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  value = *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  value = *(conv_type_t *)(((uint8_t *)block->data) + offset);
   return SD_SIGNED_CHAR_TO_NUM(value);
 }
 
@@ -1197,705 +1862,7347 @@ static VALUE sd_set_signed_char(VALUE self, VALUE sd_offset, VALUE sd_value)
 {
   typedef signed char conv_type_t;
   const size_t offset = NUM2SIZET(sd_offset);
+  sd_memory_t *const block = sd_memory_get(self);
   conv_type_t value;
-  sd_check_block_bounds(self, offset, sizeof(conv_type_t));
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  sd_check_block_bounds(block, offset, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
   value = (conv_type_t)SD_NUM_TO_SIGNED_CHAR(sd_value);
-  *(conv_type_t *)(((uint8_t *)RDATA(self)->data) + offset) = value;
+  *(conv_type_t *)(((uint8_t *)block->data) + offset) = value;
   return sd_value;
 }
 
 /*
   call-seq:
-      get_string(offset, length = nil) -> String
+    get_int8_t_array(offset, count, stride = nil) => Array
 
-  Copies a string out of the block and returns it. The length argument is used
-  to specify how the string is copied.
+  Reads count int8_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a int8_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_int8_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int8_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INT8_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
 
-  If length is nil, the string is extracted from offset up to the first null
-  character. If length is -1, it extracts all characters from offset onward in
-  the string and returns it. Otherwise, for any other length, it tries to copy
-  length characters from the block before the end of the block.
+/*
+  call-seq:
+    set_int8_t_array(offset, values, stride = nil) => values
 
-  This method does not work on zero-length blocks.
+  Writes each of the values in the given Array as a int8_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a int8_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
  */
-static VALUE sd_get_string(int argc, VALUE *argv, VALUE self)
+static VALUE sd_set_int8_array(int argc, VALUE *argv, VALUE self)
 {
-  VALUE sd_offset;
-  VALUE sd_length;
-  size_t offset;
-  size_t length       = ~(size_t)0;
-  size_t self_length  = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE));
-  const uint8_t *data = DATA_PTR(self);
-
-  sd_check_null_block(self);
+  typedef int8_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INT8(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
 
-  rb_scan_args(argc, argv, "11", &sd_offset, &sd_length);
+/*
+  call-seq:
+    get_int16_t_array(offset, count, stride = nil) => Array
 
+  Reads count int16_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a int16_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_int16_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int16_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
   offset = NUM2SIZET(sd_offset);
-
-  if (offset >= self_length) {
-    return rb_str_new("", 0);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INT16_TO_NUM(*(const conv_type_t *)data));
   }
+  return result;
+}
 
-  if (RTEST(sd_length)) {
+/*
+  call-seq:
+    set_int16_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a int16_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a int16_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_int16_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int16_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INT16(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_int32_t_array(offset, count, stride = nil) => Array
+
+  Reads count int32_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a int32_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_int32_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int32_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INT32_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_int32_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a int32_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a int32_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_int32_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int32_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INT32(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_int64_t_array(offset, count, stride = nil) => Array
+
+  Reads count int64_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a int64_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_int64_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int64_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INT64_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_int64_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a int64_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a int64_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_int64_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int64_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INT64(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_uint8_t_array(offset, count, stride = nil) => Array
+
+  Reads count uint8_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a uint8_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_uint8_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint8_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UINT8_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_uint8_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a uint8_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a uint8_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_uint8_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint8_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UINT8(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_uint16_t_array(offset, count, stride = nil) => Array
+
+  Reads count uint16_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a uint16_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_uint16_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint16_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UINT16_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_uint16_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a uint16_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a uint16_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_uint16_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint16_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UINT16(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_uint32_t_array(offset, count, stride = nil) => Array
+
+  Reads count uint32_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a uint32_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_uint32_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint32_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UINT32_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_uint32_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a uint32_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a uint32_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_uint32_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint32_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UINT32(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_uint64_t_array(offset, count, stride = nil) => Array
+
+  Reads count uint64_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a uint64_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_uint64_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint64_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UINT64_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_uint64_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a uint64_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a uint64_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_uint64_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uint64_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UINT64(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_size_t_array(offset, count, stride = nil) => Array
+
+  Reads count size_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a size_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_size_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef size_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_SIZE_T_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_size_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a size_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a size_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_size_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef size_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_SIZE_T(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_ptrdiff_t_array(offset, count, stride = nil) => Array
+
+  Reads count ptrdiff_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a ptrdiff_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_ptrdiff_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef ptrdiff_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_PTRDIFF_T_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_ptrdiff_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a ptrdiff_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a ptrdiff_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_ptrdiff_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef ptrdiff_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_PTRDIFF_T(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_intptr_t_array(offset, count, stride = nil) => Array
+
+  Reads count intptr_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a intptr_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_intptr_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef intptr_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INTPTR_T_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_intptr_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a intptr_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a intptr_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_intptr_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef intptr_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INTPTR_T(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_uintptr_t_array(offset, count, stride = nil) => Array
+
+  Reads count uintptr_t values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a uintptr_t. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_uintptr_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uintptr_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UINTPTR_T_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_uintptr_t_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a uintptr_t into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a uintptr_t. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_uintptr_t_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef uintptr_t conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UINTPTR_T(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_long_array(offset, count, stride = nil) => Array
+
+  Reads count long values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a long. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_LONG_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_long_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a long into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a long. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_LONG(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_long_long_array(offset, count, stride = nil) => Array
+
+  Reads count long long values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a long long. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_long_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef long long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_LONG_LONG_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_long_long_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a long long into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a long long. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_long_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef long long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_LONG_LONG(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_unsigned_long_array(offset, count, stride = nil) => Array
+
+  Reads count unsigned long values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a unsigned long. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_unsigned_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UNSIGNED_LONG_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_unsigned_long_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a unsigned long into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a unsigned long. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_unsigned_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UNSIGNED_LONG(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_unsigned_long_long_array(offset, count, stride = nil) => Array
+
+  Reads count unsigned long long values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a unsigned long long. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_unsigned_long_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned long long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UNSIGNED_LONG_LONG_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_unsigned_long_long_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a unsigned long long into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a unsigned long long. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_unsigned_long_long_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned long long conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UNSIGNED_LONG_LONG(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_float_array(offset, count, stride = nil) => Array
+
+  Reads count float values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a float. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_float_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef float conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_FLOAT_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_float_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a float into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a float. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_float_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef float conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_FLOAT(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_double_array(offset, count, stride = nil) => Array
+
+  Reads count double values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a double. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_double_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef double conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_DOUBLE_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_double_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a double into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a double. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_double_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef double conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_DOUBLE(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_int_array(offset, count, stride = nil) => Array
+
+  Reads count int values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a int. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_int_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_INT_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_int_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a int into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a int. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_int_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef int conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_INT(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_unsigned_int_array(offset, count, stride = nil) => Array
+
+  Reads count unsigned int values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a unsigned int. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_unsigned_int_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned int conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UNSIGNED_INT_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_unsigned_int_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a unsigned int into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a unsigned int. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_unsigned_int_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned int conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UNSIGNED_INT(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_short_array(offset, count, stride = nil) => Array
+
+  Reads count short values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a short. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_short_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef short conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_SHORT_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_short_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a short into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a short. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_short_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef short conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_SHORT(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_unsigned_short_array(offset, count, stride = nil) => Array
+
+  Reads count unsigned short values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a unsigned short. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_unsigned_short_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned short conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UNSIGNED_SHORT_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_unsigned_short_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a unsigned short into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a unsigned short. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_unsigned_short_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned short conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UNSIGNED_SHORT(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_char_array(offset, count, stride = nil) => Array
+
+  Reads count char values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a char. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_CHAR_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_char_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a char into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a char. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_CHAR(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_unsigned_char_array(offset, count, stride = nil) => Array
+
+  Reads count unsigned char values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a unsigned char. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_unsigned_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_UNSIGNED_CHAR_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_unsigned_char_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a unsigned char into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a unsigned char. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_unsigned_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef unsigned char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_UNSIGNED_CHAR(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  call-seq:
+    get_signed_char_array(offset, count, stride = nil) => Array
+
+  Reads count signed char values from the memory block, starting at the offset and
+  stepping stride bytes between each value, and returns them as an Array. If
+  stride is nil, it defaults to the size of a signed char. The entire range is
+  bounds-checked once before any values are read.
+ */
+static VALUE sd_get_signed_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef signed char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_count, sd_stride, result;
+  size_t offset, count, stride, index;
+  const uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_count, &sd_stride);
+  offset = NUM2SIZET(sd_offset);
+  count = NUM2SIZET(sd_count);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  result = rb_ary_new2((long)count);
+  data = ((const uint8_t *)block->data) + offset;
+  for (index = 0; index < count; ++index, data += stride) {
+    rb_ary_push(result, SD_SIGNED_CHAR_TO_NUM(*(const conv_type_t *)data));
+  }
+  return result;
+}
+
+/*
+  call-seq:
+    set_signed_char_array(offset, values, stride = nil) => values
+
+  Writes each of the values in the given Array as a signed char into the memory block,
+  starting at the offset and stepping stride bytes between each value. If
+  stride is nil, it defaults to the size of a signed char. The entire range is
+  bounds-checked once before any values are written. Returns the values.
+ */
+static VALUE sd_set_signed_char_array(int argc, VALUE *argv, VALUE self)
+{
+  typedef signed char conv_type_t;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_values, sd_stride;
+  size_t offset, count, stride, index;
+  uint8_t *data;
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_values, &sd_stride);
+  Check_Type(sd_values, T_ARRAY);
+  offset = NUM2SIZET(sd_offset);
+  count = (size_t)RARRAY_LEN(sd_values);
+  stride = sd_get_stride(sd_stride, sizeof(conv_type_t));
+  sd_check_block_range(block, offset, count, stride, sizeof(conv_type_t));
+  sd_check_null_block(block);
+  sd_check_writable(self, block);
+  data = ((uint8_t *)block->data) + offset;
+  for (index = 0; index < count && index < (size_t)RARRAY_LEN(sd_values); ++index, data += stride) {
+    *(conv_type_t *)data = (conv_type_t)SD_NUM_TO_SIGNED_CHAR(RARRAY_AREF(sd_values, (long)index));
+  }
+  return sd_values;
+}
+
+/*
+  Returns the number of bytes before the first null character in the length
+  bytes at data, or length if there isn't one.
+ */
+static size_t sd_strnlen(const uint8_t *data, size_t length)
+{
+  const uint8_t *const terminator = memchr(data, 0, length);
+  return terminator ? (size_t)(terminator - data) : length;
+}
+
+/*
+  A pin on a block held by one of its String views. The view references it as
+  a hidden ivar, so the pin is released when the view is collected. The pin
+  also keeps the Memory object alive while the view is.
+ */
+typedef struct s_sd_view_pin {
+  sd_view_pins_t *pins;
+  VALUE          owner;
+} sd_view_pin_t;
+
+static void sd_view_pin_dmark(void *ptr)
+{
+  rb_gc_mark(((sd_view_pin_t *)ptr)->owner);
+}
+
+static void sd_view_pin_dfree(void *ptr)
+{
+  sd_view_pin_t *const pin = (sd_view_pin_t *)ptr;
+  sd_view_pins_t *const pins = pin->pins;
+
+  if (pins) {
+    pins->count -= 1;
+    if (pins->block) {
+      pins->block->pinned -= 1;
+    } else if (pins->count == 0) {
+      xfree(pins);
+    }
+  }
+
+  xfree(pin);
+}
+
+static const rb_data_type_t sd_view_pin_type = {
+  "Snow::Memory::ViewPin",
+  { sd_view_pin_dmark, sd_view_pin_dfree, NULL, },
+  0, 0,
+  RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+  Pins self's block and returns a hidden object holding the pin until it's
+  collected.
+ */
+static VALUE sd_view_pin_new(VALUE self, sd_memory_t *block)
+{
+  sd_view_pin_t *pin;
+  const VALUE sd_pin = TypedData_Make_Struct(0, sd_view_pin_t, &sd_view_pin_type, pin);
+
+  if (!block->view_pins) {
+    block->view_pins = ZALLOC(sd_view_pins_t);
+    block->view_pins->block = block;
+  }
+
+  RB_OBJ_WRITE(sd_pin, &pin->owner, self);
+  pin->pins = block->view_pins;
+  pin->pins->count += 1;
+  block->pinned += 1;
+
+  return sd_pin;
+}
+
+/*
+  call-seq:
+      view(offset = 0, length = nil) => String
+      view(offset, length, null_terminated) => String
+
+  Returns a frozen, binary String that shares length bytes of the block starting
+  at offset rather than copying them. If length is nil, the view extends to
+  the end of the block. If null_terminated is true, the view ends before the
+  first null character in that range.
+
+  The String keeps the receiver alive for as long as it exists, and while it
+  does, the receiver refuses to free! or realloc! its block (raising a
+  RuntimeError). Once every view of the block has been collected, it can be
+  freed or reallocated again.
+
+  Because the bytes are shared, later writes to the block show up in the
+  String. If the receiver doesn't own its block (e.g., it wraps part of a
+  struct array or an address from elsewhere), the view is only valid as long as
+  whatever owns the block keeps it alive.
+
+  Raises a RangeError if the range is outside the block.
+ */
+static VALUE sd_memory_view(int argc, VALUE *argv, VALUE self)
+{
+  static ID id_pin = 0;
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_length, sd_null_terminated;
+  size_t offset, length;
+  const uint8_t *data;
+  VALUE view;
+
+  rb_scan_args(argc, argv, "03", &sd_offset, &sd_length, &sd_null_terminated);
+
+  offset = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  if (offset > block->bytesize) {
+    rb_raise(rb_eRangeError, "Offset %zu is out of bounds (bytesize: %zu)",
+      offset, block->bytesize);
+  }
+
+  length = RTEST(sd_length) ? NUM2SIZET(sd_length) : block->bytesize - offset;
+  sd_check_block_bounds(block, offset, length);
+  sd_check_null_block(block);
+
+  data = (const uint8_t *)block->data + offset;
+  if (RTEST(sd_null_terminated)) {
+    length = sd_strnlen(data, length);
+  }
+
+  if (!id_pin) {
+    id_pin = rb_intern("__snow_data_view_pin__");
+  }
+
+  view = rb_str_new_static((const char *)data, (long)length);
+  /* A hidden ivar, since it has no @ -- keeps self alive and its block pinned
+     while view is */
+  rb_ivar_set(view, id_pin, sd_view_pin_new(self, block));
+  rb_obj_freeze(view);
+
+  return view;
+}
+
+#ifdef SD_HAS_MEMORY_VIEW
+/*
+  MemoryView export, so other extensions (Fiddle, Numo::NArray, etc.) can use
+  a block's bytes without copying them through a String. Plain Memory objects
+  are exported as unsigned bytes. Objects that respond to __memory_view_format__
+  (struct and struct array classes) are exported as a one-dimensional array of
+  items in that format, with the format's item size as the stride. Objects that
+  respond to __memory_view_bytesize__ (struct vectors) export only that many
+  bytes from the start of the block.
+
+  Like String views, a block is pinned while any MemoryView of it is held, so
+  it can't be freed or reallocated out from under the consumer.
+ */
+
+typedef struct s_sd_memory_view_data
+{
+  ssize_t shape[1];
+  ssize_t strides[1];
+  char    format[];
+} sd_memory_view_data_t;
+
+static ID sd_id_memory_view_format = 0;
+static ID sd_id_memory_view_bytesize = 0;
+
+static bool sd_memory_view_get(VALUE self, rb_memory_view_t *view, int flags)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  const bool readonly = block->readonly || OBJ_FROZEN(self);
+  sd_memory_view_data_t *view_data;
+  VALUE sd_format, sd_bytesize;
+  size_t bytesize = block->bytesize;
+  ssize_t item_size;
+  long format_length = 0;
+
+  if (!block->data || (readonly && (flags & RUBY_MEMORY_VIEW_WRITABLE))) {
+    return false;
+  }
+
+  sd_bytesize = rb_check_funcall(self, sd_id_memory_view_bytesize, 0, NULL);
+  if (sd_bytesize != Qundef && !NIL_P(sd_bytesize)) {
+    bytesize = NUM2SIZET(sd_bytesize);
+    if (bytesize > block->bytesize) {
+      return false;
+    }
+  }
+  if (bytesize > (size_t)SSIZE_MAX) {
+    return false;
+  }
+
+  sd_format = rb_check_funcall(self, sd_id_memory_view_format, 0, NULL);
+  if (sd_format == Qundef || NIL_P(sd_format)) {
+    item_size = 1;
+    sd_format = Qnil;
+  } else {
+    StringValueCStr(sd_format);
+    format_length = RSTRING_LEN(sd_format);
+    item_size = rb_memory_view_item_size_from_format(RSTRING_PTR(sd_format), NULL);
+    if (item_size <= 0 || bytesize % (size_t)item_size != 0) {
+      return false;
+    }
+  }
+
+  /* Copy the format, since nothing keeps the String alive until release */
+  view_data = ruby_xmalloc(sizeof(*view_data) + (size_t)format_length + 1);
+  view_data->shape[0] = (ssize_t)bytesize / item_size;
+  view_data->strides[0] = item_size;
+  if (NIL_P(sd_format)) {
+    view_data->format[0] = '\0';
+  } else {
+    memcpy(view_data->format, RSTRING_PTR(sd_format), (size_t)format_length + 1);
+  }
+
+  view->obj = self;
+  view->data = block->data;
+  view->byte_size = (ssize_t)bytesize;
+  view->readonly = readonly;
+  view->format = NIL_P(sd_format) ? NULL : view_data->format;
+  view->item_size = item_size;
+  view->item_desc.components = NULL;
+  view->item_desc.length = 0;
+  view->ndim = 1;
+  view->shape = view_data->shape;
+  view->strides = view_data->strides;
+  view->sub_offsets = NULL;
+  view->private_data = view_data;
+
+  block->pinned += 1;
+
+  return true;
+}
+
+static bool sd_memory_view_release(VALUE self, rb_memory_view_t *view)
+{
+  sd_memory_get(self)->pinned -= 1;
+  ruby_xfree(view->private_data);
+  return true;
+}
+
+static bool sd_memory_view_available(VALUE self)
+{
+  return sd_memory_get(self)->data != NULL;
+}
+
+static const rb_memory_view_entry_t sd_memory_view_entry = {
+  sd_memory_view_get,
+  sd_memory_view_release,
+  sd_memory_view_available
+};
+#endif
+
+/*
+  call-seq:
+      get_string(offset, length = nil) -> String
+
+  Copies a string out of the block and returns it. The length argument is used
+  to specify how the string is copied.
+
+  If length is nil, the string is extracted from offset up to the first null
+  character. If length is -1, it extracts all characters from offset onward in
+  the string and returns it. Otherwise, for any other length, it tries to copy
+  length characters from the block before the end of the block.
+
+  This method does not work on zero-length blocks.
+ */
+static VALUE sd_get_string(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_offset;
+  VALUE sd_length;
+  size_t offset;
+  size_t length       = ~(size_t)0;
+  sd_memory_t *block  = sd_memory_get(self);
+  size_t self_length  = block->bytesize;
+  const uint8_t *data = block->data;
+
+  sd_check_null_block(block);
+
+  rb_scan_args(argc, argv, "11", &sd_offset, &sd_length);
+
+  offset = NUM2SIZET(sd_offset);
+
+  if (offset >= self_length) {
+    return rb_str_new("", 0);
+  }
+
+  if (RTEST(sd_length)) {
+    length = NUM2SIZET(sd_length);
+
+    if (length == ~(size_t)0
+        || (offset + length) > self_length
+        || (offset + length) < offset) {
+      length = self_length - offset;
+    }
+  } else {
+    length = sd_strnlen(data + offset, self_length - offset);
+  }
+
+  return rb_str_new((const char *)(data + offset), length);
+}
+
+static VALUE sd_set_string_nullterm(VALUE self, VALUE sd_offset, VALUE sd_value, int null_terminated)
+{
+  sd_memory_t *block         = sd_memory_get(self);
+  uint8_t *data              = block->data;
+  const uint8_t *string_data = (const uint8_t *)StringValueCStr(sd_value);
+  size_t offset              = NUM2SIZET(sd_offset);
+  /* Subtract 1 from the block length to account for a null character) */
+  size_t length              = block->bytesize - null_terminated;
+  size_t str_length          = RSTRING_LEN(sd_value);
+
+  sd_check_writable(self, block);
+
+  if (offset >= length) {
+    return sd_value;
+  }
+
+  length -= offset;
+  if (str_length < length) {
+    length = str_length;
+  }
+
+  if (length > 0) {
+    memcpy(data + offset, string_data, length);
+  }
+
+  if (null_terminated) {
+    data[offset + length] = '\0';
+  }
+
+  return sd_value;
+}
+
+/*
+  call-seq:
+      set_string(offset, value, null_terminated = false) -> value
+
+  Copies the string value into the block at the offset supplied.
+
+  If null_terminated is true, it will always write a null-terminating character
+  if it fits. This means that you need at least string.bytesize + 1 bytes
+  available from the offset onwards to fully story a string, otherwise the
+  string's contents will be truncated to fit the null-terminating character.
+
+  If null_terminated is false, no null character is written and only the string
+  bytes are copied to the block. If the full string does not fit, it will be
+  truncated.
+ */
+static VALUE sd_set_string(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_offset, sd_value, sd_null_terminated;
+
+  sd_check_null_block(sd_memory_get(self));
+  sd_check_writable(self, sd_memory_get(self));
+
+  rb_scan_args(argc, argv, "21", &sd_offset, &sd_value, &sd_null_terminated);
+
+  return sd_set_string_nullterm(self, sd_offset, sd_value, !!RTEST(sd_null_terminated));
+}
+
+/*
+  Slab pools. A pool hands out fixed-size slots carved from slabs of
+  slots_per_slab slots each, keeping freed slots in an intrusive free list (each
+  free slot holds the address of the next). Slots are only padded out to the
+  pool's alignment, and slabs are only freed with the pool.
+
+  A pool outlives its Pool object if slots are still in use when the object is
+  collected, in which case it's destroyed once its last slot is released.
+ */
+
+#define SD_POOL_DEFAULT_SLAB_SIZE (16 * 1024)
+
+typedef struct s_sd_pool_slab {
+  struct s_sd_pool_slab *next;
+  void                  *data;
+} sd_pool_slab_t;
+
+typedef struct s_sd_pool {
+  sd_pool_slab_t  *slabs;
+  void            *free_list;
+  size_t          size;           /* Size of the objects stored in slots. */
+  size_t          slot_size;
+  size_t          alignment;
+  size_t          slots_per_slab;
+  size_t          slab_count;
+  size_t          live;
+  size_t          free;
+  int             orphaned;       /* Set once the Pool object is collected. */
+} sd_pool_t;
+
+static void sd_pool_destroy(sd_pool_t *pool)
+{
+  sd_pool_slab_t *slab = pool->slabs;
+  while (slab) {
+    sd_pool_slab_t *const next = slab->next;
+    com_free(slab->data, pool->slot_size * pool->slots_per_slab, pool->alignment);
+    free(slab);
+    slab = next;
+  }
+  xfree(pool);
+}
+
+/*
+  Returns a zeroed slot from the pool, allocating a new slab if the free list
+  is empty.
+ */
+static void *sd_pool_acquire(sd_pool_t *pool)
+{
+  void *slot;
+
+  if (!pool->free_list) {
+    const size_t slab_size = pool->slot_size * pool->slots_per_slab;
+    uint8_t *const data = com_malloc(slab_size, pool->alignment, SD_ZERO_MEMORY);
+    /* Not ALLOC, which would raise and leak data if it failed */
+    sd_pool_slab_t *const slab = malloc(sizeof(*slab));
+    size_t index;
+
+    if (!slab) {
+      com_free(data, slab_size, pool->alignment);
+      rb_raise(rb_eNoMemError, "Failed to allocate a pool slab");
+    }
+
+    slab->data = data;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->slab_count += 1;
+
+    /* Thread the slab's slots onto the free list in address order */
+    for (index = pool->slots_per_slab; index > 0; --index) {
+      void *const free_slot = data + (index - 1) * pool->slot_size;
+      *(void **)free_slot = pool->free_list;
+      pool->free_list = free_slot;
+    }
+    pool->free += pool->slots_per_slab;
+  }
+
+  slot = pool->free_list;
+  pool->free_list = *(void **)slot;
+  pool->free -= 1;
+  pool->live += 1;
+
+  memset(slot, 0, pool->slot_size);
+  return slot;
+}
+
+/*
+  Returns a slot to the pool's free list, destroying the pool if it's been
+  orphaned and this was its last live slot.
+ */
+static void sd_pool_release(sd_pool_t *pool, void *slot)
+{
+  *(void **)slot = pool->free_list;
+  pool->free_list = slot;
+  pool->free += 1;
+  pool->live -= 1;
+
+  if (pool->orphaned && pool->live == 0) {
+    sd_pool_destroy(pool);
+  }
+}
+
+/*
+  Frees or releases the block owned by a Memory object, if it owns one, and
+  clears its ownership. Does not clear the block's data pointer or size.
+ */
+static void sd_memory_release_block(sd_memory_t *block)
+{
+  sd_class_stats_release(block);
+  if (block->pool) {
+    sd_pool_release(block->pool, block->data);
+    block->pool = NULL;
+  } else if (block->free_func) {
+    block->free_func(block->data, block->bytesize, block->alignment);
+    block->free_func = 0;
+  }
+}
+
+/*
+  Frees memory associated with self regardless of whether the object is frozen.
+ */
+static void sd_memory_force_free(VALUE self)
+{
+  sd_memory_t *block = sd_memory_get(self);
+
+  if (block->pinned) {
+    rb_raise(rb_eRuntimeError, "Cannot free %s while views share its block",
+      rb_obj_classname(self));
+  } else if (block->data) {
+    sd_memory_release_block(block);
+  } else {
+    rb_raise(rb_eRuntimeError,
+      "Double-free on %s",
+      rb_obj_classname(self));
+  }
+
+  block->data = 0;
+  block->bytesize = 0;
+}
+
+/*
+  Marks the object a Memory object's block belongs to, if any.
+ */
+static void sd_memory_dmark(void *ptr)
+{
+  const sd_memory_t *block = (const sd_memory_t *)ptr;
+  if (block->owner) {
+    rb_gc_mark(block->owner);
+  }
+}
+
+/*
+  Frees a Memory object's sd_memory_t and, if the object owns it, its block.
+  Called by the GC.
+ */
+static void sd_memory_dfree(void *ptr)
+{
+  sd_memory_t *block = (sd_memory_t *)ptr;
+
+  if (block->data) {
+    sd_memory_release_block(block);
+  }
+
+  if (block->view_pins) {
+    block->view_pins->block = NULL;
+    if (block->view_pins->count == 0) {
+      xfree(block->view_pins);
+    }
+  }
+
+  xfree(block);
+}
+
+/*
+  Returns the memory used by a Memory object, including its block if it owns
+  it. Used by ObjectSpace.memsize_of.
+ */
+static size_t sd_memory_dsize(const void *ptr)
+{
+  const sd_memory_t *block = (const sd_memory_t *)ptr;
+  size_t size = sizeof(*block);
+
+  if (block->data && block->free_func) {
+    size += block->bytesize;
+  }
+
+  return size;
+}
+
+/*
+  Allocator for Memory and its subclasses. Objects allocated this way have a
+  NULL, zero-length block until they're given one by sd_wrap_memory or
+  realloc!.
+ */
+static VALUE sd_memory_alloc(VALUE klass)
+{
+  sd_memory_t *block;
+  return TypedData_Make_Struct(klass, sd_memory_t, &sd_memory_type, block);
+}
+
+/*
+  Returns a Memory object of the given klass wrapping data with the given size
+  and alignment, without calling its initialize. Callers that give the object
+  a block it owns other than through should_free must set up ownership before
+  calling initialize, so the block is freed with the object if it raises.
+ */
+static VALUE sd_wrap_memory_uninitialized(VALUE klass, void *data, size_t size, size_t alignment, sd_free_memory_flag_t should_free)
+{
+  sd_memory_t *block;
+  VALUE memory = TypedData_Make_Struct(klass, sd_memory_t, &sd_memory_type, block);
+  block->data       = data;
+  block->bytesize   = size;
+  block->alignment  = alignment;
+  block->free_func  = (should_free ? com_free : 0);
+  if (should_free) {
+    sd_class_stats_own(klass, block);
+  }
+  return memory;
+}
+
+/*
+  Returns a Memory object of the given klass wrapping data with the given size
+  and alignment.
+ */
+static VALUE sd_wrap_memory(VALUE klass, void *data, size_t size, size_t alignment, sd_free_memory_flag_t should_free)
+{
+  VALUE memory = sd_wrap_memory_uninitialized(klass, data, size, alignment, should_free);
+  rb_obj_call_init(memory, 0, 0);
+  return memory;
+}
+
+/*
+  call-seq:
+      new(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
+      wrap(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
+      __wrap__(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
+
+  Creates a new Memory object that wraps an existing pointer. Alignment is
+  optional and defaults to the size of a pointer (Memory::SIZEOF_VOID_POINTER).
+
+  Size must be greater than zero. Zero-sized blocks are not permitted as they
+  render most memory functionality useless and make it very difficult to ensure
+  nothing bad is happening when you do bad things with snow-data. Because, let's
+  be honest with ourselves for a moment, everyone using this gem? They're bad
+  people. They're very bad people.
+
+  Note that Memory objects created with this method will not attempt to free
+  the memory they wrap, as they did not allocate it and so do not own it. If
+  an address held by a Memory object is invalid, the Memory object is also
+  implicitly invalid as well, though there is no way for it to check this. You
+  are responsible for freeing any memory not allocated through ::malloc and
+  Memory subclasses.
+
+  It is an ArgumentError to provide a size of zero, nil, or false. It is also
+  an ArgumentError to provide a NULL (zero) address.
+
+  If a subclass overrides ::new, it is also aliased as ::wrap and ::__wrap__.
+  Subclasses may override ::wrap or ::new but must never override ::__wrap__.
+ */
+static VALUE sd_memory_new(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_size;
+  VALUE sd_address;
+  VALUE sd_alignment;
+  VALUE memory = Qnil;
+  void *address;
+  size_t size;
+  size_t alignment;
+
+  rb_scan_args(argc, argv, "21", &sd_address, &sd_size, &sd_alignment);
+
+  address = (void *)SD_NUM_TO_INTPTR_T(sd_address);
+  size = 0;
+  alignment = SIZEOF_VOIDP;
+
+  if (address == NULL) {
+    rb_raise(rb_eArgError, "Address is NULL (%p).", address);
+  }
+
+  if (RTEST(sd_size)) {
+    size = NUM2SIZET(sd_size);
+  } else {
+    rb_raise(rb_eArgError, "Block size is false or nil");
+  }
+
+  if (!size) {
+    rb_raise(rb_eArgError, "Block size must be 1 or greater");
+  }
+
+  if (RTEST(sd_alignment)) {
+    alignment = NUM2SIZET(sd_alignment);
+  }
+
+  memory = sd_wrap_memory(self, address, size, alignment, SD_DO_NOT_FREE_MEMORY);
+
+  return memory;
+}
+
+#ifdef SD_HAS_MMAP
+/*
+  Anonymous mappings, used by malloc for mmap-backed blocks. A block starts on
+  a page boundary (or a huge page boundary for huge page blocks) and is mapped
+  to its size rounded up to a whole number of pages. These have their own free
+  function so they aren't mistaken for file mappings by msync!, advise, unmap!,
+  or realloc!.
+ */
+
+/* Boundary huge page blocks are aligned to: the usual x86-64 and arm64 huge
+   page size */
+#define SD_HUGE_PAGE_SIZE   (2 * 1024 * 1024)
+/* Highest NUMA node number plus one that blocks can be bound to */
+#define SD_MAX_NUMA_NODES   1024
+
+static size_t sd_anon_map_length(size_t size)
+{
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  return (size + (page_size - 1)) & ~(page_size - 1);
+}
+
+static void sd_anon_munmap_free(void *data, size_t bytesize, size_t alignment)
+{
+  const size_t length = sd_anon_map_length(bytesize);
+  (void)alignment;
+  munmap(data, length);
+  sd_gc_adjust_memory_usage(-(ssize_t)length);
+  sd_stats_freed(bytesize);
+}
+
+#ifdef SD_HAS_MBIND
+/*
+  Binds the pages of a mapping to a NUMA node. Unmaps the mapping and raises a
+  SystemCallError if it fails.
+ */
+static void sd_anon_bind_node(void *data, size_t length, size_t node)
+{
+  unsigned long mask[SD_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+  const size_t bits_per_long = 8 * sizeof(unsigned long);
+
+  memset(mask, 0, sizeof(mask));
+  mask[node / bits_per_long] = 1UL << (node % bits_per_long);
+
+  /* 2 is MPOL_BIND; the kernel reads one less than maxnode bits of the mask */
+  if (syscall(SYS_mbind, data, length, 2, mask, (unsigned long)SD_MAX_NUMA_NODES + 1, 0) != 0) {
+    const int error = errno;
+    munmap(data, length);
+    errno = error;
+    rb_sys_fail("mbind");
+  }
+}
+#endif
+
+/*
+  Maps an anonymous, zeroed block of at least size bytes for malloc. If
+  huge_pages is nonzero, the block is aligned to SD_HUGE_PAGE_SIZE and
+  madvise'd to use transparent huge pages where supported. If numa_node isn't
+  negative, the block's pages are bound to that node.
+
+  Raises an ArgumentError if the alignment is larger than the block's boundary,
+  a NotImplementedError if a NUMA node is given but can't be bound to, and a
+  NoMemoryError if the block can't be mapped. These are all checked before
+  mapping anything.
+ */
+static void *sd_anon_mmap(size_t size, size_t alignment, int huge_pages, long numa_node)
+{
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t boundary = huge_pages && SD_HUGE_PAGE_SIZE > page_size ? SD_HUGE_PAGE_SIZE : page_size;
+  const size_t length = sd_anon_map_length(size);
+  size_t map_length;
+  uint8_t *base;
+  uint8_t *data;
+
+  #ifndef SD_HAS_MBIND
+  if (numa_node >= 0) {
+    rb_raise(rb_eNotImpError, "NUMA node binding is not supported on this platform");
+  }
+  #endif
+
+  if (alignment > boundary) {
+    rb_raise(rb_eArgError, "Alignment of mmap-backed blocks can be at most %zu", boundary);
+  } else if (numa_node >= SD_MAX_NUMA_NODES) {
+    rb_raise(rb_eArgError, "NUMA node must be less than %d", SD_MAX_NUMA_NODES);
+  } else if (length < size || length > SIZE_MAX - boundary) {
+    rb_raise(rb_eRangeError, "Size %zu is too large to map", size);
+  }
+
+  /* Map enough to trim the block to its boundary */
+  map_length = length + (boundary - page_size);
+  base = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    rb_gc();
+    base = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+
+  if (base == MAP_FAILED) {
+    rb_raise(rb_eNoMemError, "Failed to map %zu (req: %zu) bytes via mmap", map_length, size);
+    return NULL;
+  }
+
+  data = align_ptr(base, boundary);
+  if (data > base) {
+    munmap(base, (size_t)(data - base));
+  }
+  if (data + length < base + map_length) {
+    munmap(data + length, (size_t)((base + map_length) - (data + length)));
+  }
+
+  #if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+  if (huge_pages) {
+    /* Only a hint -- if transparent huge pages are off, the block still works */
+    madvise(data, length, MADV_HUGEPAGE);
+  }
+  #endif
+
+  #ifdef SD_HAS_MBIND
+  if (numa_node >= 0) {
+    sd_anon_bind_node(data, length, (size_t)numa_node);
+  }
+  #endif
+
+  sd_gc_adjust_memory_usage((ssize_t)length);
+  sd_stats_allocated(size);
+
+  return data;
+}
+
+#ifdef HAVE_MREMAP
+/*
+  Resizes an anonymous mapping from sd_anon_mmap with mremap, which moves the
+  block's pages rather than copying them. The new mapping is only guaranteed
+  to start on a page boundary. Pages added to the block are zeroed. Raises a
+  NoMemoryError if the mapping can't be resized, in which case the old mapping
+  is left as-is.
+ */
+static void *sd_anon_mremap(void *data, size_t old_size, size_t new_size)
+{
+  const size_t old_length = sd_anon_map_length(old_size);
+  const size_t new_length = sd_anon_map_length(new_size);
+  void *new_data;
+
+  if (new_length < new_size) {
+    rb_raise(rb_eRangeError, "Size %zu is too large to map", new_size);
+  }
+
+  new_data = mremap(data, old_length, new_length, MREMAP_MAYMOVE);
+  if (new_data == MAP_FAILED) {
+    rb_gc();
+    new_data = mremap(data, old_length, new_length, MREMAP_MAYMOVE);
+  }
+
+  if (new_data == MAP_FAILED) {
+    rb_raise(rb_eNoMemError, "Failed to remap %zu bytes to %zu (req: %zu) bytes via mremap",
+      old_length, new_length, new_size);
+    return NULL;
+  }
+
+  sd_gc_adjust_memory_usage((ssize_t)new_length - (ssize_t)old_length);
+
+  return new_data;
+}
+#endif
+#endif
+
+/*
+  Returns whether to zero a new block given a method's keyword options, which
+  may be nil or a Hash with a :zero key. Defaults to SD_ZERO_MEMORY.
+ */
+static sd_zero_memory_flag_t sd_get_zero_option(VALUE sd_options)
+{
+  ID keys[1];
+  VALUE values[1];
+
+  if (NIL_P(sd_options)) {
+    return SD_ZERO_MEMORY;
+  }
+
+  keys[0] = rb_intern("zero");
+  rb_get_kwargs(sd_options, keys, 0, 1, values);
+  return (values[0] == Qundef || RTEST(values[0])) ? SD_ZERO_MEMORY : SD_DO_NOT_ZERO_MEMORY;
+}
+
+/*
+  call-seq:
+      malloc(size, alignment = nil, zero: true, mmap: false, huge_pages: false, numa_node: nil) => Memory
+      __malloc__(size, alignment = nil, zero: true, mmap: false, huge_pages: false, numa_node: nil) => Memory
+
+  Allocates a new block with the given size and alignment and returns it. If
+  no alignment is specified, it defaults to Snow::Memory::SIZEOF_VOID_POINTER.
+
+  The block is zeroed unless zero is false, in which case its contents are
+  undefined until written to. Skipping the zeroing is only worthwhile for
+  large blocks that are about to be overwritten anyway (e.g., by copy! or
+  read_from).
+
+  Large blocks can be mapped directly with mmap rather than allocated from
+  the C heap by passing mmap: true. The block starts on a page boundary, so
+  alignment may be up to the page size. Two more options only apply to mapped
+  blocks, so passing either implies mmap: true:
+
+  [huge_pages: true]   Align the block to a 2mb boundary and ask the kernel to
+                       back it with transparent huge pages, which cuts TLB
+                       misses when accessing very large blocks at random.
+                       This is only a hint and is ignored if the kernel
+                       doesn't support it.
+  [numa_node: node]    Bind the block's pages to the given NUMA node (Linux
+                       only). Raises a SystemCallError if the node can't be
+                       used.
+
+  Mapped blocks are always zeroed, since fresh pages come from the kernel
+  zeroed, and use at least a page of memory, so they only make sense for
+  blocks of many pages. Raises an ArgumentError if zero: false is combined
+  with any of these options, and a NotImplementedError if they aren't
+  supported on this platform.
+
+  Raises a RangeError if either size is zero or alignment is not a power of two.
+
+  If a subclass overrides ::malloc, which is a bad idea and should not be done,
+  then it is aliased as ::__malloc__ as well. Subclasses must never override
+  ::__malloc__.
+ */
+static VALUE sd_memory_malloc(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_size;
+  VALUE sd_alignment;
+  VALUE sd_options;
+  size_t alignment;
+  size_t size;
+  void *data;
+  VALUE memory;
+  ID option_keys[4];
+  VALUE options[4] = { Qundef, Qundef, Qundef, Qundef };
+  sd_zero_memory_flag_t zero = SD_ZERO_MEMORY;
+  int use_mmap, huge_pages;
+
+  rb_scan_args(argc, argv, "11:", &sd_size, &sd_alignment, &sd_options);
+
+  if (!NIL_P(sd_options)) {
+    option_keys[0] = rb_intern("zero");
+    option_keys[1] = rb_intern("mmap");
+    option_keys[2] = rb_intern("huge_pages");
+    option_keys[3] = rb_intern("numa_node");
+    rb_get_kwargs(sd_options, option_keys, 0, 4, options);
+    if (options[0] != Qundef && !RTEST(options[0])) {
+      zero = SD_DO_NOT_ZERO_MEMORY;
+    }
+  }
+
+  huge_pages = options[2] != Qundef && RTEST(options[2]);
+  use_mmap = huge_pages || (options[1] != Qundef && RTEST(options[1])) ||
+             (options[3] != Qundef && !NIL_P(options[3]));
+
+  if (use_mmap && zero == SD_DO_NOT_ZERO_MEMORY) {
+    rb_raise(rb_eArgError, "Mapped blocks are always zeroed -- zero: false "
+      "cannot be combined with mmap, huge_pages, or numa_node");
+  }
+
+  /* Get size and alignment */
+  size = NUM2SIZET(sd_size);
+  alignment = RTEST(sd_alignment) ? NUM2SIZET(sd_alignment) : sizeof(void *);
+  if (!is_power_of_two(alignment)) {
+    rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not a"
+      " power of two", alignment);
+  } else if (size < 1) {
+    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
+      " blocks are not permitted");
+  }
+
+  if (use_mmap) {
+    #ifdef SD_HAS_MMAP
+    sd_memory_t *block;
+    const long numa_node = (options[3] == Qundef || NIL_P(options[3])) ? -1 : NUM2LONG(options[3]);
+
+    if (options[3] != Qundef && !NIL_P(options[3]) && numa_node < 0) {
+      rb_raise(rb_eArgError, "NUMA node must be 0 or greater");
+    }
+
+    data = sd_anon_mmap(size, alignment, huge_pages, numa_node);
+    memory = sd_wrap_memory_uninitialized(self, data, size, alignment, SD_DO_NOT_FREE_MEMORY);
+    block = sd_memory_get(memory);
+    block->free_func = sd_anon_munmap_free;
+    sd_class_stats_own(self, block);
+    rb_obj_call_init(memory, 0, 0);
+    return memory;
+    #else
+    rb_raise(rb_eNotImpError, "mmap-backed blocks are not supported on this platform");
+    #endif
+  }
+
+  /* Allocate block */
+  data = com_malloc(size, alignment, zero);
+  memory = sd_wrap_memory(self, data, size, alignment, SD_FREE_MEMORY);
+
+  return memory;
+}
+
+#ifdef SD_ALLOW_ALLOCA
+/*
+  call-seq:
+      alloca(size) { |memory| ... } => result of block
+      __alloca__(size) { |memory| ... } => result of block
+
+  Allocates size bytes on the stack and yields it to a block before for use,
+  then returns the result of the block. Outside of the block, any use of the
+  yielded memory's address is considered undefined behavior and may lead to
+  crashes or worse. The yielded memory is only valid for the duration of the
+  block. If you want to preserve the memory after use, either duplicate the
+  memory block or realloc! the memory, both of which will copy it from the stack
+  to the heap.
+
+  The alignment of the yielded memory is always the size of a pointer.
+
+  Because of how downright evil alloca is in some situations, it is disabled by
+  default. You must explicitly install snow-data with the --allow-alloca flag to
+  use this function. If you're not certain whether alloca is available for a
+  particular installation, then you should check if the Memory class responds to
+  it first.
+
+      if Snow::Memory.respond_to?(:__alloca__)
+        Snow::Memory.__alloca__(64) { |mem|
+          # ...
+        }
+      end
+
+  Subclasses may override alloca to provide a predefined size argument, but
+  subclasses must never override __alloca__. It is considered bad form to
+  implement __alloca__ using heap allocation for installations that don't
+  provide it.
+ */
+static VALUE sd_memory_alloca(VALUE self, VALUE sd_size)
+{
+  VALUE result = Qnil;
+  void *stack_memory = NULL;
+  sd_memory_t *block_data;
+  size_t size = NUM2SIZET(sd_size);
+  VALUE block;
+
+  rb_need_block();
+
+  if (size == 0) {
+    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
+      " blocks are not permitted.");
+  }
+
+  stack_memory = alloca(size);
+  if (stack_memory == NULL) {
+    rb_raise(rb_eNoMemError,
+      "Failed to allocated %zu bytes via alloca",
+      size);
+  }
+
+  block = sd_wrap_memory(self, stack_memory, size, SIZEOF_VOIDP, SD_DO_NOT_FREE_MEMORY);
+  block_data = sd_memory_get(block);
+  result = rb_yield(block);
+
+  /*
+    If the block hasn't been realloc!'d or freed, free it now if it hasn't been
+    frozen for some reason.
+   */
+  if (block_data->data == stack_memory && !block_data->free_func && !OBJ_FROZEN(block)) {
+    sd_memory_force_free(block);
+  }
+
+  return result;
+}
+#endif
+
+#ifdef SD_HAS_MMAP
+/*
+  Unmaps a block mapped by __map__. The block may start partway into a page if
+  it was mapped at an offset that isn't page-aligned, so this rounds the
+  address down to the page and grows the length to match.
+ */
+static void sd_munmap_free(void *data, size_t bytesize, size_t alignment)
+{
+  const uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  const uintptr_t address = (uintptr_t)data;
+  const uintptr_t base = address & ~(page_size - 1);
+  (void)alignment;
+  munmap((void *)base, bytesize + (size_t)(address - base));
+}
+
+/*
+  Returns the block of a Memory object created by __map__, raising a
+  RuntimeError if the object's block isn't a mapping it owns.
+ */
+static sd_memory_t *sd_memory_get_mapped(VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  if (!block->data || block->free_func != sd_munmap_free) {
+    rb_raise(rb_eRuntimeError, "%s is not a mapped block", rb_obj_classname(self));
+  }
+  return block;
+}
+
+/*
+  call-seq:
+      __map__(path, offset, length, mode) => Memory
+
+  Maps length bytes of the file at path, starting at offset, into memory and
+  returns a Memory object of the receiving class that owns the mapping. If
+  length is nil, the rest of the file after offset is mapped.
+
+  Mode may be one of the following:
+
+  [:read]       The file is mapped read-only. The block is marked read-only
+                (see #readonly?), so methods that write to it raise a
+                RuntimeError rather than crash the process.
+  [:read_write] The file is mapped shared and writable. Writes go to the file,
+                though not necessarily until #msync! is called or the block is
+                unmapped.
+  [:private]    The file is mapped copy-on-write. Writes are visible only to the
+                block and never reach the file.
+
+  The mapping is unmapped when the object is freed, either by #free!, #unmap!,
+  or the GC. Raises a RangeError if the range to map is empty or extends past
+  the end of the file and a SystemCallError if the file can't be opened or
+  mapped.
+
+  You should normally use Memory::map rather than call this directly.
+ */
+static VALUE sd_memory_map(VALUE self, VALUE sd_path, VALUE sd_offset, VALUE sd_length, VALUE sd_mode)
+{
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const ID mode = SYMBOL_P(sd_mode) ? SYM2ID(sd_mode) : 0;
+  const size_t offset = NUM2SIZET(sd_offset);
+  int open_flags, prot, map_flags, fd;
+  size_t length, map_offset, alignment;
+  struct stat file_stat;
+  void *mapping;
+  uint8_t *data;
+  VALUE memory;
+
+  if (mode == rb_intern("read")) {
+    open_flags = O_RDONLY;
+    prot       = PROT_READ;
+    map_flags  = MAP_SHARED;
+  } else if (mode == rb_intern("read_write")) {
+    open_flags = O_RDWR;
+    prot       = PROT_READ | PROT_WRITE;
+    map_flags  = MAP_SHARED;
+  } else if (mode == rb_intern("private")) {
+    open_flags = O_RDONLY;
+    prot       = PROT_READ | PROT_WRITE;
+    map_flags  = MAP_PRIVATE;
+  } else {
+    rb_raise(rb_eArgError, "Invalid map mode %"PRIsVALUE" -- must be :read,"
+      " :read_write, or :private", sd_mode);
+  }
+
+  FilePathValue(sd_path);
+  fd = rb_cloexec_open(StringValueCStr(sd_path), open_flags, 0);
+  if (fd < 0) {
+    rb_sys_fail_str(sd_path);
+  }
+  rb_update_max_fd(fd);
+
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    rb_sys_fail_str(sd_path);
+  }
+
+  if ((off_t)offset > file_stat.st_size) {
+    close(fd);
+    rb_raise(rb_eRangeError, "Offset %zu is past the end of %"PRIsVALUE, offset, sd_path);
+  }
+
+  if (NIL_P(sd_length)) {
+    length = (size_t)(file_stat.st_size - (off_t)offset);
+  } else {
     length = NUM2SIZET(sd_length);
+    if (length > (size_t)(file_stat.st_size - (off_t)offset)) {
+      close(fd);
+      rb_raise(rb_eRangeError, "Cannot map %zu bytes at offset %zu of %"PRIsVALUE
+        " -- the range extends past the end of the file", length, offset, sd_path);
+    }
+  }
+
+  if (length == 0) {
+    close(fd);
+    rb_raise(rb_eRangeError, "Cannot map a zero-length block of %"PRIsVALUE, sd_path);
+  }
+
+  map_offset = offset & ~(page_size - 1);
+  mapping = mmap(NULL, length + (offset - map_offset), prot, map_flags, fd, (off_t)map_offset);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    rb_sys_fail_str(sd_path);
+  }
+
+  data = (uint8_t *)mapping + (offset - map_offset);
+
+  /* The block's alignment is the largest power of two its address is aligned
+     to, up to the page size */
+  for (alignment = page_size; (uintptr_t)data & (alignment - 1); alignment >>= 1)
+    ;
+
+  memory = sd_wrap_memory_uninitialized(self, data, length, alignment, SD_DO_NOT_FREE_MEMORY);
+  sd_memory_get(memory)->free_func = sd_munmap_free;
+  sd_memory_get(memory)->readonly = !(prot & PROT_WRITE);
+  rb_obj_call_init(memory, 0, 0);
+
+  return memory;
+}
+
+/*
+  Returns the page-aligned start and length of the pages covering length bytes
+  at offset into a mapped block, checking that the range is in bounds. If
+  sd_length is nil, the range extends to the end of the block.
+ */
+static void sd_memory_mapped_range(VALUE self, VALUE sd_offset, VALUE sd_length,
+  void **page_start, size_t *page_length)
+{
+  const sd_memory_t *block = sd_memory_get_mapped(self);
+  const uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  const size_t offset = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  size_t length;
+  uintptr_t start;
+
+  if (offset > block->bytesize) {
+    rb_raise(rb_eRangeError, "Offset %zu is out of bounds (bytesize: %zu)",
+      offset, block->bytesize);
+  }
+
+  length = RTEST(sd_length) ? NUM2SIZET(sd_length) : block->bytesize - offset;
+  sd_check_block_bounds(block, offset, length);
+
+  start = ((uintptr_t)block->data + offset) & ~(page_size - 1);
+  *page_start = (void *)start;
+  *page_length = length + (size_t)(((uintptr_t)block->data + offset) - start);
+}
+
+/*
+  call-seq:
+      msync!(offset = nil, length = nil, async = false) => self
+
+  Flushes writes to a mapped block back to its file. If given, offset and
+  length limit the flush to the pages covering that range of the block. If
+  async is true, the flush is scheduled and the method returns immediately.
+
+  Raises a RuntimeError if the block isn't a mapping owned by the receiver.
+ */
+static VALUE sd_memory_msync(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_offset, sd_length, sd_async;
+  void *start;
+  size_t length;
+
+  rb_scan_args(argc, argv, "03", &sd_offset, &sd_length, &sd_async);
+  sd_memory_mapped_range(self, sd_offset, sd_length, &start, &length);
+
+  if (msync(start, length, RTEST(sd_async) ? MS_ASYNC : MS_SYNC) != 0) {
+    rb_sys_fail("msync");
+  }
+
+  return self;
+}
+
+/*
+  call-seq:
+      advise(advice, offset = nil, length = nil) => self
+
+  Tells the OS how a mapped block (or the pages covering a range of it) will be
+  accessed so it can adjust read-ahead and caching. Advice may be one of
+  :normal, :random, :sequential, :willneed, or :dontneed. This is only a hint,
+  and the OS is free to ignore it.
+
+  Raises a RuntimeError if the block isn't a mapping owned by the receiver.
+ */
+static VALUE sd_memory_advise(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_advice, sd_offset, sd_length;
+  ID advice_id;
+  int advice;
+  void *start;
+  size_t length;
+
+  rb_scan_args(argc, argv, "12", &sd_advice, &sd_offset, &sd_length);
+
+  advice_id = SYMBOL_P(sd_advice) ? SYM2ID(sd_advice) : 0;
+  if (advice_id == rb_intern("normal")) {
+    advice = POSIX_MADV_NORMAL;
+  } else if (advice_id == rb_intern("random")) {
+    advice = POSIX_MADV_RANDOM;
+  } else if (advice_id == rb_intern("sequential")) {
+    advice = POSIX_MADV_SEQUENTIAL;
+  } else if (advice_id == rb_intern("willneed")) {
+    advice = POSIX_MADV_WILLNEED;
+  } else if (advice_id == rb_intern("dontneed")) {
+    advice = POSIX_MADV_DONTNEED;
+  } else {
+    rb_raise(rb_eArgError, "Invalid advice %"PRIsVALUE, sd_advice);
+  }
+
+  sd_memory_mapped_range(self, sd_offset, sd_length, &start, &length);
+
+  if ((errno = posix_madvise(start, length, advice)) != 0) {
+    rb_sys_fail("posix_madvise");
+  }
+
+  return self;
+}
+
+/*
+  call-seq:
+      unmap!() => self
+
+  Unmaps a mapped block. Unlike #free!, this works on frozen (i.e., read-only)
+  mappings, since unmapping doesn't write to the block.
+
+  Raises a RuntimeError if the block isn't a mapping owned by the receiver.
+ */
+static VALUE sd_memory_unmap(VALUE self)
+{
+  sd_memory_get_mapped(self);
+  sd_memory_force_free(self);
+  return self;
+}
+#endif
+
+#ifdef SD_HAS_FD_IO
+/*
+  Direct IO. Bytes move straight between a file descriptor and a block with the
+  GVL released for each syscall, rather than through an intermediate String.
+ */
+
+typedef struct s_sd_io_call {
+  int     fd;
+  void    *data;
+  size_t  length;
+  off_t   position;   /* File position for pread/pwrite, or -1 */
+  ssize_t result;
+  int     error;
+} sd_io_call_t;
+
+typedef struct s_sd_io_transfer {
+  VALUE   self;
+  VALUE   io;         /* IO object, or nil if given a descriptor */
+  int     fd;
+  int     writing;
+  uint8_t *data;
+  size_t  length;
+  off_t   position;   /* File position for pread/pwrite, or -1 */
+} sd_io_transfer_t;
+
+static void *sd_io_read_nogvl(void *ptr)
+{
+  sd_io_call_t *const call = (sd_io_call_t *)ptr;
+  #if defined(HAVE_PREAD)
+  if (call->position >= 0) {
+    call->result = pread(call->fd, call->data, call->length, call->position);
+  } else
+  #endif
+  {
+    call->result = read(call->fd, call->data, call->length);
+  }
+  call->error = errno;
+  return NULL;
+}
+
+static void *sd_io_write_nogvl(void *ptr)
+{
+  sd_io_call_t *const call = (sd_io_call_t *)ptr;
+  #if defined(HAVE_PWRITE)
+  if (call->position >= 0) {
+    call->result = pwrite(call->fd, call->data, call->length, call->position);
+  } else
+  #endif
+  {
+    call->result = write(call->fd, call->data, call->length);
+  }
+  call->error = errno;
+  return NULL;
+}
+
+/*
+  Reads or writes the transfer's full length, stopping early only at EOF when
+  reading. Waits on the descriptor and retries on EAGAIN and EINTR. Returns the
+  number of bytes transferred.
+ */
+static VALUE sd_io_transfer(VALUE arg)
+{
+  static ID id_readpartial = 0;
+  sd_io_transfer_t *const transfer = (sd_io_transfer_t *)arg;
+  size_t total = 0;
+  sd_io_call_t call;
+
+  /* Bytes the IO has already buffered would otherwise be skipped */
+  if (!transfer->writing && transfer->position < 0 && !NIL_P(transfer->io) &&
+      transfer->length > 0 && rb_io_read_pending(RFILE(transfer->io)->fptr)) {
+    VALUE buffered;
+    if (!id_readpartial) {
+      id_readpartial = rb_intern("readpartial");
+    }
+    buffered = rb_funcall(transfer->io, id_readpartial, 1, SIZET2NUM(transfer->length));
+    StringValue(buffered);
+    total = (size_t)RSTRING_LEN(buffered);
+    if (total > transfer->length) {
+      total = transfer->length;
+    }
+    memcpy(transfer->data, RSTRING_PTR(buffered), total);
+  }
+
+  while (total < transfer->length) {
+    call.fd       = transfer->fd;
+    call.data     = transfer->data + total;
+    call.length   = transfer->length - total;
+    call.position = transfer->position < 0 ? -1 : transfer->position + (off_t)total;
+    call.result   = -1;
+    call.error    = 0;
+
+    rb_thread_call_without_gvl(
+      transfer->writing ? sd_io_write_nogvl : sd_io_read_nogvl, &call,
+      RUBY_UBF_IO, NULL);
+
+    if (call.result > 0) {
+      total += (size_t)call.result;
+    } else if (call.result == 0 && !transfer->writing) {
+      break;
+    } else {
+      errno = call.error;
+      if (call.result < 0 && (transfer->writing
+          ? rb_io_wait_writable(transfer->fd)
+          : rb_io_wait_readable(transfer->fd))) {
+        continue;
+      }
+      rb_syserr_fail(call.error ? call.error : EIO, transfer->writing ? "write" : "read");
+    }
+  }
+
+  return SIZET2NUM(total);
+}
+
+static VALUE sd_io_unpin(VALUE self)
+{
+  sd_memory_get(self)->pinned -= 1;
+  return Qnil;
+}
+
+/*
+  Shared implementation of read_from, write_to, pread, and pwrite. Resolves io
+  to a descriptor, checks the block range, and runs the transfer with the block
+  pinned so it can't be freed or reallocated while the GVL is released.
+ */
+static VALUE sd_memory_io(VALUE self, VALUE sd_io, VALUE sd_position,
+  VALUE sd_offset, VALUE sd_length, int writing)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  sd_io_transfer_t transfer;
+  size_t offset;
+
+  if (!writing) {
+    sd_check_writable(self, block);
+  }
+
+  offset = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  if (offset > block->bytesize) {
+    rb_raise(rb_eRangeError, "Offset %zu is out of bounds (bytesize: %zu)",
+      offset, block->bytesize);
+  }
+
+  transfer.length = RTEST(sd_length) ? NUM2SIZET(sd_length) : block->bytesize - offset;
+  sd_check_block_bounds(block, offset, transfer.length);
+  sd_check_null_block(block);
+
+  if (RB_INTEGER_TYPE_P(sd_io)) {
+    transfer.io = Qnil;
+    transfer.fd = NUM2INT(sd_io);
+  } else {
+    rb_io_t *fptr;
+    transfer.io = rb_io_get_io(sd_io);
+    GetOpenFile(transfer.io, fptr);
+    if (writing) {
+      rb_io_check_writable(fptr);
+      rb_io_flush(transfer.io);
+    } else {
+      rb_io_check_readable(fptr);
+    }
+    #ifdef HAVE_RB_IO_DESCRIPTOR
+    transfer.fd = rb_io_descriptor(transfer.io);
+    #else
+    transfer.fd = fptr->fd;
+    #endif
+  }
+
+  transfer.self     = self;
+  transfer.writing  = writing;
+  transfer.data     = (uint8_t *)block->data + offset;
+  transfer.position = NIL_P(sd_position) ? -1 : NUM2OFFT(sd_position);
+
+  if (!NIL_P(sd_position) && transfer.position < 0) {
+    rb_raise(rb_eArgError, "File position must not be negative");
+  }
+
+  block->pinned += 1;
+  return rb_ensure(sd_io_transfer, (VALUE)&transfer, sd_io_unpin, self);
+}
+
+/*
+  call-seq:
+      read_from(io, offset = 0, length = nil) => Integer
+
+  Reads length bytes from io, an IO or a file descriptor, into the block at
+  offset and returns the number of bytes read. If length is nil, it reads
+  enough to fill the rest of the block. Like IO#read, this only stops short of
+  length at end of file, and returns 0 if io is already at end of file.
+
+  The GVL is released during each read, so other threads keep running while
+  the read blocks. Data already buffered by an IO object is read first.
+
+  Raises a RangeError if the range is outside the block and a SystemCallError
+  if the read fails.
+ */
+static VALUE sd_memory_read_from(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_io, sd_offset, sd_length;
+  rb_scan_args(argc, argv, "12", &sd_io, &sd_offset, &sd_length);
+  return sd_memory_io(self, sd_io, Qnil, sd_offset, sd_length, 0);
+}
+
+/*
+  call-seq:
+      write_to(io, offset = 0, length = nil) => Integer
+
+  Writes length bytes of the block starting at offset to io, an IO or a file
+  descriptor, and returns the number of bytes written. If length is nil, it
+  writes the rest of the block. An IO object's write buffer is flushed first.
+
+  The GVL is released during each write. Raises a RangeError if the range is
+  outside the block and a SystemCallError if the write fails.
+ */
+static VALUE sd_memory_write_to(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_io, sd_offset, sd_length;
+  rb_scan_args(argc, argv, "12", &sd_io, &sd_offset, &sd_length);
+  return sd_memory_io(self, sd_io, Qnil, sd_offset, sd_length, 1);
+}
+
+#if defined(HAVE_PREAD) && defined(HAVE_PWRITE)
+/*
+  call-seq:
+      pread(io, position, offset = 0, length = nil) => Integer
+
+  Like #read_from, but reads from the given position in the file with pread(2)
+  rather than from its current position, which is left unchanged. Bytes
+  buffered by an IO object are ignored.
+ */
+static VALUE sd_memory_pread(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_io, sd_position, sd_offset, sd_length;
+  rb_scan_args(argc, argv, "22", &sd_io, &sd_position, &sd_offset, &sd_length);
+  return sd_memory_io(self, sd_io, sd_position, sd_offset, sd_length, 0);
+}
+
+/*
+  call-seq:
+      pwrite(io, position, offset = 0, length = nil) => Integer
+
+  Like #write_to, but writes at the given position in the file with pwrite(2)
+  rather than at its current position, which is left unchanged.
+ */
+static VALUE sd_memory_pwrite(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_io, sd_position, sd_offset, sd_length;
+  rb_scan_args(argc, argv, "22", &sd_io, &sd_position, &sd_offset, &sd_length);
+  return sd_memory_io(self, sd_io, sd_position, sd_offset, sd_length, 1);
+}
+#endif
+#endif
+
+/*
+  call-seq:
+      realloc!(size, alignment = nil, zero: true) => self
+
+  Reallocates the memory backing this pointer with a new size and optionally a
+  new alignment. If the new size is the same as the old size, the method returns
+  early and nothing is reallocated.
+
+  If a new alignment is specified, the memory will be reallocated regardless of
+  whether the new and old sizes are the same. If no alignment is specified, the
+  memory's previous alignment is used.
+
+  If the block for this memory was previously freed or the block is not owner by
+  this object, a new block is allocated and the memory takes ownership of it.
+  It is fine to realloc! on a previously freed block.
+
+  If the block grows, the new bytes past the old size are zeroed unless zero
+  is false, in which case they're undefined until written to.
+
+  Blocks allocated by malloc or a previous realloc! that keep their alignment
+  are resized with the C library's realloc, which can usually resize the block
+  without copying it. Blocks mapped by malloc's mmap options are resized with
+  mremap where available, and stay mapped. Other blocks are copied to a new
+  block.
+
+  Raises a RangeError if either size is zero or alignment is not a power of two.
+ */
+static VALUE sd_memory_realloc(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *data;
+  void *new_data;
+  size_t size;
+  size_t prev_size;
+  size_t prev_align;
+  size_t alignment;
+  VALUE sd_size;
+  VALUE sd_alignment;
+  VALUE sd_options;
+  sd_zero_memory_flag_t zero;
+  size_t copied = 0;
+  size_t zero_end;
+  void (*free_func)(void *data, size_t bytesize, size_t alignment) = com_free;
+
+  /*
+    Don't check for null/zero length here, as it is safe to reuse a memory via
+    realloc!. It's less safe for structs and arrays, but you just have to do the
+    sane thing in most cases. Granted, I'm a hypocrite for saying you need to
+    do the sane thing after writing this gem.
+   */
+  data = sd_memory_get(self);
+  sd_check_writable(self, data);
+
+  rb_scan_args(argc, argv, "11:", &sd_size, &sd_alignment, &sd_options);
+
+  size       = NUM2SIZET(sd_size);
+
+  if (data->pinned) {
+    rb_raise(rb_eRuntimeError, "Cannot realloc %s while views share its block",
+      rb_obj_classname(self));
+  }
+  prev_align =
+  alignment  = data->alignment;
+  prev_size  = data->bytesize;
+
+  if (RTEST(sd_alignment)) {
+    alignment = NUM2SIZET(sd_alignment);
+  }
+
+  if (prev_size == size && alignment == prev_align) {
+    return self;
+  } else if (!is_power_of_two(alignment)) {
+    rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not a"
+      " power of two", alignment);
+  } else if (size < 1) {
+    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
+      " blocks are not permitted");
+  }
+
+  zero = sd_get_zero_option(sd_options);
+  zero_end = size;
+
+  if (data->data && data->free_func == com_free && alignment == prev_align) {
+    /*
+      The block came from com_malloc and keeps its alignment, so let realloc
+      resize it, possibly without moving it.
+     */
+    new_data = com_realloc(data->data, prev_size, size, alignment);
+    copied = prev_size < size ? prev_size : size;
+    sd_stats_resized(data, prev_size, size);
+    free_func = com_free;
+  #if defined(SD_HAS_MMAP) && defined(HAVE_MREMAP)
+  } else if (data->data && data->free_func == sd_anon_munmap_free &&
+             alignment == prev_align && alignment <= (size_t)sysconf(_SC_PAGESIZE)) {
+    /*
+      Mapped blocks from malloc are remapped, and stay mapped. Bytes up to the
+      end of the old mapping's last page may be stale, but any pages past that
+      are fresh and already zeroed.
+     */
+    const size_t old_length = sd_anon_map_length(prev_size);
+    new_data = sd_anon_mremap(data->data, prev_size, size);
+    copied = prev_size < size ? prev_size : size;
+    zero_end = size < old_length ? size : old_length;
+    sd_stats_resized(data, prev_size, size);
+    free_func = sd_anon_munmap_free;
+  #endif
+  } else {
+    /* Only the bytes past the old contents need zeroing, so do that below */
+    new_data = com_malloc(size, alignment, SD_DO_NOT_ZERO_MEMORY);
+
+    if (data->data && prev_size > 0) {
+      const size_t copy_sizes[2] = { prev_size, size };
+      copied = copy_sizes[prev_size > size];
+      memcpy(new_data, data->data, copied);
+    }
+
+    if (data->free_func || data->pool) {
+      sd_memory_release_block(data);
+    } else if (data->data) {
+      rb_warning("realloc called on unowned pointer %p -- allocating new block"
+        " and memcpying contents (size: %zd bytes), but original block will"
+        " not be freed.", data->data, prev_size);
+    }
+  }
+
+  if (SD_PROBE_ENABLED(realloc)) {
+    SD_PROBE6(realloc, data->data, new_data, prev_size, size, alignment,
+      rb_obj_classname(self));
+  }
+
+  if (zero && zero_end > copied) {
+    memset((uint8_t *)new_data + copied, 0, zero_end - copied);
+  }
+
+  data->data      = new_data;
+  data->free_func = free_func;
+  data->bytesize  = size;
+  data->alignment = alignment;
+  sd_stats.reallocs += 1;
+  if (!data->class_stats) {
+    sd_class_stats_own(rb_obj_class(self), data);
+  }
+
+  return self;
+}
+
+/*
+  call-seq:
+      free!() => self
+
+  Frees any memory owned by the object. This is a convenience function for when
+  you want to free the memory ahead of the object being collected by the GC.
+ */
+static VALUE sd_memory_free(VALUE self)
+{
+  rb_check_frozen(self);
+  sd_memory_force_free(self);
+  return self;
+}
+
+/*
+  Parallel tasks. sd_parallel_run splits a job into tasks, numbered from zero,
+  and runs them on a pool of native worker threads, with the calling thread
+  taking tasks as well. It must be called without the GVL, since the tasks
+  mustn't touch Ruby objects. Only one job runs on the pool at a time -- a job
+  started while the pool is busy runs its tasks on the calling thread.
+
+  Worker threads are started as needed, up to Memory.parallelism - 1 of them,
+  and live until the process exits. Without pthreads, every job runs serially.
+ */
+
+#define SD_MAX_PARALLELISM          256
+#define SD_PARALLEL_MIN_TASK_BYTES  (1024 * 1024)
+
+typedef void (*sd_task_fn_t)(void *context, size_t task);
+
+static size_t sd_parallelism = 1;
+
+/* Defined with the operations that release the GVL, below */
+static size_t sd_nogvl_threshold;
+
+/*
+  Returns how many tasks to split an operation over bytes bytes into, given
+  the current parallelism. Each task covers at least
+  SD_PARALLEL_MIN_TASK_BYTES, as threads don't pay for themselves below that.
+  Operations too small to release the GVL (see sd_call_maybe_without_gvl) run
+  as a single task, since sd_parallel_run must be called without the GVL.
+ */
+static size_t sd_parallel_task_count(size_t bytes)
+{
+  size_t tasks = bytes / SD_PARALLEL_MIN_TASK_BYTES;
+  if (bytes < sd_nogvl_threshold) {
+    return 1;
+  }
+  if (tasks > sd_parallelism) {
+    tasks = sd_parallelism;
+  }
+  return tasks ? tasks : 1;
+}
+
+#ifdef SD_HAS_PTHREAD
+
+static struct s_sd_workers {
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;       /* Signalled when a job starts */
+  pthread_cond_t  done;       /* Signalled when a job's last task finishes */
+  pthread_mutex_t run_lock;   /* Held by the thread running a job */
+  size_t          count;      /* Worker threads started */
+  unsigned long   generation; /* Incremented for each job */
+  sd_task_fn_t    fn;
+  void            *context;
+  size_t          tasks;
+  size_t          next_task;
+  size_t          pending;    /* Tasks not yet finished */
+} sd_workers = {
+  PTHREAD_MUTEX_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_COND_INITIALIZER,
+  PTHREAD_MUTEX_INITIALIZER,
+  0, 0, NULL, NULL, 0, 0, 0
+};
+
+/*
+  Runs tasks of the current job until none are left. Must be called with the
+  lock held, and returns with it held.
+ */
+static void sd_workers_drain(void)
+{
+  while (sd_workers.next_task < sd_workers.tasks) {
+    const size_t task = sd_workers.next_task++;
+    const sd_task_fn_t fn = sd_workers.fn;
+    void *const context = sd_workers.context;
+
+    pthread_mutex_unlock(&sd_workers.lock);
+    fn(context, task);
+    pthread_mutex_lock(&sd_workers.lock);
+
+    if (--sd_workers.pending == 0) {
+      pthread_cond_signal(&sd_workers.done);
+    }
+  }
+}
+
+static void *sd_worker_main(void *arg)
+{
+  unsigned long seen = (unsigned long)(uintptr_t)arg;
+
+  pthread_mutex_lock(&sd_workers.lock);
+  for (;;) {
+    while (sd_workers.generation == seen) {
+      pthread_cond_wait(&sd_workers.wake, &sd_workers.lock);
+    }
+    seen = sd_workers.generation;
+    sd_workers_drain();
+  }
+
+  return NULL;
+}
+
+/*
+  Starts worker threads until there are count of them. Workers are started
+  with all signals blocked so signals keep going to Ruby's threads. If a thread
+  can't be started, the pool just stays smaller. Must be called with the lock
+  held.
+ */
+static void sd_workers_grow(size_t count)
+{
+  sigset_t all_signals, previous;
+
+  if (sd_workers.count >= count) {
+    return;
+  }
+
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+
+  while (sd_workers.count < count) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, sd_worker_main,
+                       (void *)(uintptr_t)sd_workers.generation) != 0) {
+      break;
+    }
+    pthread_detach(thread);
+    sd_workers.count += 1;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+/*
+  A forked child has none of its parent's worker threads, and the locks may
+  have been held by threads that no longer exist, so start over.
+ */
+static void sd_workers_after_fork(void)
+{
+  pthread_mutex_init(&sd_workers.lock, NULL);
+  pthread_mutex_init(&sd_workers.run_lock, NULL);
+  pthread_cond_init(&sd_workers.wake, NULL);
+  pthread_cond_init(&sd_workers.done, NULL);
+  sd_workers.count      = 0;
+  sd_workers.tasks      = 0;
+  sd_workers.next_task  = 0;
+  sd_workers.pending    = 0;
+}
+
+static void sd_parallel_run(sd_task_fn_t fn, void *context, size_t tasks)
+{
+  size_t task;
+
+  if (tasks > 1 && pthread_mutex_trylock(&sd_workers.run_lock) == 0) {
+    pthread_mutex_lock(&sd_workers.lock);
+    sd_workers_grow(tasks - 1);
+
+    sd_workers.fn         = fn;
+    sd_workers.context    = context;
+    sd_workers.tasks      = tasks;
+    sd_workers.next_task  = 0;
+    sd_workers.pending    = tasks;
+    sd_workers.generation += 1;
+    pthread_cond_broadcast(&sd_workers.wake);
+
+    sd_workers_drain();
+    while (sd_workers.pending > 0) {
+      pthread_cond_wait(&sd_workers.done, &sd_workers.lock);
+    }
+
+    sd_workers.tasks = 0;
+    pthread_mutex_unlock(&sd_workers.lock);
+    pthread_mutex_unlock(&sd_workers.run_lock);
+    return;
+  }
+
+  for (task = 0; task < tasks; ++task) {
+    fn(context, task);
+  }
+}
+
+#else
+
+static void sd_parallel_run(sd_task_fn_t fn, void *context, size_t tasks)
+{
+  size_t task;
+  for (task = 0; task < tasks; ++task) {
+    fn(context, task);
+  }
+}
+
+#endif
+
+/*
+  call-seq:
+      parallelism => Integer
+
+  Returns the number of threads used to run large bulk operations (copy!,
+  fill!, compare, and the reduce_ methods). Defaults to 1.
+ */
+static VALUE sd_memory_get_parallelism(VALUE self)
+{
+  return SIZET2NUM(sd_parallelism);
+}
+
+/*
+  call-seq:
+      parallelism = count => count
+
+  Sets the number of threads, including the calling thread, used to run large
+  bulk operations. Operations are only split up once they cover a megabyte or
+  more per thread and at least ::nogvl_threshold bytes in all, as only
+  operations that release the GVL are split.
+  count may be at most 256. Without pthreads, this has no effect.
+ */
+static VALUE sd_memory_set_parallelism(VALUE self, VALUE sd_count)
+{
+  const size_t count = NUM2SIZET(sd_count);
+  if (count < 1 || count > SD_MAX_PARALLELISM) {
+    rb_raise(rb_eArgError, "Parallelism must be between 1 and %d", SD_MAX_PARALLELISM);
+  }
+  sd_parallelism = count;
+  return sd_count;
+}
+
+/*
+  Operations that release the GVL. Operations on at least sd_nogvl_threshold
+  bytes run with the GVL released so other threads can run in the meantime.
+  The blocks involved are pinned while the GVL is released so they can't be
+  freed or reallocated out from under the operation.
+ */
+
+#define SD_DEFAULT_NOGVL_THRESHOLD (1024 * 1024)
+
+static size_t sd_nogvl_threshold = SD_DEFAULT_NOGVL_THRESHOLD;
+
+typedef struct s_sd_nogvl_call {
+  void        *(*func)(void *);
+  void        *arg;
+  sd_memory_t *pins[2];
+} sd_nogvl_call_t;
+
+static VALUE sd_nogvl_call(VALUE arg)
+{
+  sd_nogvl_call_t *const call = (sd_nogvl_call_t *)arg;
+  /* No unblocking function: these operations can't be interrupted partway */
+  rb_thread_call_without_gvl(call->func, call->arg, NULL, NULL);
+  return Qnil;
+}
+
+static VALUE sd_nogvl_unpin(VALUE arg)
+{
+  sd_nogvl_call_t *const call = (sd_nogvl_call_t *)arg;
+  if (call->pins[0]) {
+    call->pins[0]->pinned -= 1;
+  }
+  if (call->pins[1]) {
+    call->pins[1]->pinned -= 1;
+  }
+  return Qnil;
+}
+
+/*
+  Calls func(arg), releasing the GVL first if the operation covers at least
+  sd_nogvl_threshold bytes. first and second are the Memory blocks involved,
+  either of which may be NULL.
+ */
+static void sd_call_maybe_without_gvl(void *(*func)(void *), void *arg, size_t size,
+  sd_memory_t *first, sd_memory_t *second)
+{
+  sd_nogvl_call_t call;
+
+  if (size < sd_nogvl_threshold) {
+    func(arg);
+    return;
+  }
+
+  call.func     = func;
+  call.arg      = arg;
+  call.pins[0]  = first;
+  call.pins[1]  = (second != first) ? second : NULL;
+  if (call.pins[0]) {
+    call.pins[0]->pinned += 1;
+  }
+  if (call.pins[1]) {
+    call.pins[1]->pinned += 1;
+  }
+
+  rb_ensure(sd_nogvl_call, (VALUE)&call, sd_nogvl_unpin, (VALUE)&call);
+}
+
+typedef enum e_sd_bulk_op_kind {
+  SD_BULK_MOVE,
+  SD_BULK_FILL,
+  SD_BULK_COMPARE
+} sd_bulk_op_kind_t;
+
+typedef struct s_sd_bulk_op {
+  sd_bulk_op_kind_t kind;
+  void              *destination;
+  const void        *source;
+  size_t            size;
+  int               value;    /* Byte to fill with, or the result of a compare */
+  size_t            tasks;
+  int               results[SD_MAX_PARALLELISM]; /* Per-task compare results */
+} sd_bulk_op_t;
+
+static void sd_bulk_op_task(void *context, size_t task)
+{
+  sd_bulk_op_t *const op = (sd_bulk_op_t *)context;
+  const size_t begin = op->size / op->tasks * task;
+  const size_t end = (task + 1 == op->tasks) ? op->size : begin + op->size / op->tasks;
+  uint8_t *const destination = (uint8_t *)op->destination + begin;
+  const uint8_t *const source = (const uint8_t *)op->source + begin;
+
+  switch (op->kind) {
+  case SD_BULK_MOVE:    memmove(destination, source, end - begin); break;
+  case SD_BULK_FILL:    memset(destination, op->value, end - begin); break;
+  case SD_BULK_COMPARE: op->results[task] = memcmp(destination, source, end - begin); break;
+  }
+}
+
+static void *sd_bulk_op_nogvl(void *ptr)
+{
+  sd_bulk_op_t *const op = (sd_bulk_op_t *)ptr;
+  const uintptr_t destination = (uintptr_t)op->destination;
+  const uintptr_t source = (uintptr_t)op->source;
+  size_t task;
+
+  op->tasks = sd_parallel_task_count(op->size);
+
+  /* Overlapping moves have to go front-to-back or back-to-front as a whole */
+  if (op->kind == SD_BULK_MOVE &&
+      destination < source + op->size && source < destination + op->size) {
+    op->tasks = 1;
+  }
+
+  sd_parallel_run(sd_bulk_op_task, op, op->tasks);
+
+  if (op->kind == SD_BULK_COMPARE) {
+    op->value = 0;
+    for (task = 0; task < op->tasks && op->value == 0; ++task) {
+      op->value = op->results[task];
+    }
+  }
+
+  return NULL;
+}
+
+/*
+  Runs a bulk operation, releasing the GVL and splitting it across threads if
+  it's large enough. first and second are the Memory blocks involved, either of
+  which may be NULL.
+ */
+static void sd_bulk_op_run(sd_bulk_op_t *op, sd_memory_t *first, sd_memory_t *second)
+{
+  sd_call_maybe_without_gvl(sd_bulk_op_nogvl, op, op->size, first, second);
+}
+
+/*
+  call-seq:
+      nogvl_threshold => Integer
+
+  Returns the size in bytes at or above which copy!, fill!, compare, the
+  reduce_ methods, and the content hashing methods release the GVL while they
+  run. Defaults to 1mb.
+ */
+static VALUE sd_memory_get_nogvl_threshold(VALUE self)
+{
+  return SIZET2NUM(sd_nogvl_threshold);
+}
+
+/*
+  call-seq:
+      nogvl_threshold = size => size
+
+  Sets the size in bytes at or above which copy!, fill!, compare, the reduce_
+  methods, and the content hashing methods release the GVL while they run.
+  Releasing the GVL has a fixed cost of its own, so very small thresholds make
+  small operations slower.
+ */
+static VALUE sd_memory_set_nogvl_threshold(VALUE self, VALUE sd_threshold)
+{
+  sd_nogvl_threshold = NUM2SIZET(sd_threshold);
+  return sd_threshold;
+}
+
+#ifdef SD_HAS_MEMORY_VIEW
+/* Runs a copy! from a MemoryView source, releasing the view afterward */
+typedef struct s_sd_copy_view
+{
+  sd_bulk_op_t     *op;
+  sd_memory_t      *block;
+  rb_memory_view_t *view;
+} sd_copy_view_t;
+
+static VALUE sd_copy_view_run(VALUE context)
+{
+  sd_copy_view_t *const copy = (sd_copy_view_t *)context;
+  sd_bulk_op_run(copy->op, copy->block, NULL);
+  return Qnil;
+}
+
+static VALUE sd_copy_view_release(VALUE context)
+{
+  rb_memory_view_release(((sd_copy_view_t *)context)->view);
+  return Qnil;
+}
+#endif
+
+/*
+  call-seq:
+      copy!(source, destination_offset = nil, source_offset = nil, byte_size = nil) => self
+
+  Copies byte_size bytes from an offset in the source data to an offset into
+  the receiver (the destination).
+
+  If either offset is nil, they default to zero.
+
+  If the byte_size is nil, it defaults to the receiver's #bytesize.
+
+  The source may be any of the following, checked in this order:
+
+  - A Memory object. Its block is read directly, without calling any methods
+    on it, so this is the fastest case.
+  - An object exporting a contiguous MemoryView, such as a Fiddle::Pointer
+    with a size. The view is held for the duration of the copy.
+  - An object responding to #address with a Numeric address, such as an
+    FFI::Pointer.
+  - A Data object, whose data pointer is used.
+  - A Numeric address.
+
+  Copies from Memory objects, MemoryViews, and objects responding to
+  #bytesize are bounds-checked against the source's size. Other sources
+  cannot be bounds-checked, so you must ensure that your source offset and
+  byte size are both within range of the source data.
+
+  For those curious, under the hood, this uses memmove, not memcpy. So, it is
+  possible to copy overlapping regions of memory, but it isn't guaranteed to be
+  as fast as a simple memcpy. Either way, if this is a concern for you, you
+  probably shouldn't be using Ruby.
+
+  Copies of at least Memory::nogvl_threshold bytes release the GVL while they
+  run, so other threads aren't stalled by large copies. Those copies are also
+  split across Memory::parallelism threads if the source and destination
+  don't overlap.
+
+  === Exceptions
+
+  - If attempting to copy into a region that is outside the bounds of the
+    receiver will raise a RangeError.
+  - If attempting to copy from outside the bounds of a source with a known
+    size will raise a RangeError.
+  - If either the receiver or the source address is NULL, it will raise an
+    ArgumentError.
+  - If the source object is none of the above, it raises a TypeError.
+ */
+static VALUE sd_memory_copy(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_source;
+  VALUE sd_destination_offset;
+  VALUE sd_source_offset;
+  VALUE sd_byte_size;
+  sd_memory_t *self_data = sd_memory_get(self);
+  sd_memory_t *source_block = NULL;
+  const uint8_t *source_pointer;
+  uint8_t *destination_pointer;
+  size_t source_offset;
+  size_t destination_offset;
+  size_t byte_size;
+  size_t self_byte_size;
+  size_t source_size = 0;
+  int source_is_bounded = 0;
+  int source_is_data = 0;
+  sd_bulk_op_t op;
+  #ifdef SD_HAS_MEMORY_VIEW
+  rb_memory_view_t source_view;
+  int source_is_view = 0;
+  #endif
+
+  sd_check_null_block(self_data);
+  sd_check_writable(self, self_data);
+
+  rb_scan_args(argc, argv, "13",
+    &sd_source,
+    &sd_destination_offset,
+    &sd_source_offset,
+    &sd_byte_size);
+
+  /* Grab data from ruby values. */
+  source_offset       = RTEST(sd_source_offset) ? NUM2SIZET(sd_source_offset) : 0;
+  destination_offset  = RTEST(sd_destination_offset) ? NUM2SIZET(sd_destination_offset) : 0;
+  destination_pointer = (uint8_t *)self_data->data + destination_offset;
+  self_byte_size      = self_data->bytesize;
+
+  if (self_byte_size == 0) {
+    /*
+      If self is a zero-length block, do not try to copy. It's just not sane to
+      attempt it here since we can't do any bounds checking, even if the bounds
+      might be arbitrarily specified (in which case I'd just be shooting myself
+      in the foot if I did that and trying to circumvent the anti-foot-shot
+      protections).
+     */
+    rb_raise(rb_eRuntimeError, "self.bytesize == 0 -- cannot safely copy to this block");
+  } else if (!RTEST(sd_byte_size)) {
+    /*
+      If not copy size is specified, use self_byte_size and just try to cram as
+      much in there as is feasible. Truncate self_byte_size as needed for the
+      offset.
+     */
+    byte_size = self_byte_size - destination_offset;
+  } else {
+    /* User-specified size */
+    byte_size = NUM2SIZET(sd_byte_size);
+  }
+
+  if ((destination_offset + byte_size) > self_byte_size
+      || (destination_offset + byte_size) < destination_offset) {
+    rb_raise(rb_eRangeError,
+      "Offset %zu with byte size %zu is out of bounds of self",
+      destination_offset,
+      byte_size);
+  }
+
+  if (rb_typeddata_is_kind_of(sd_source, &sd_memory_type)) {
+    /*
+      Memory objects are by far the most common source, so read their blocks
+      directly rather than going through #address and #bytesize.
+     */
+    source_block      = sd_memory_get(sd_source);
+    source_pointer    = source_block->data;
+    source_size       = source_block->bytesize;
+    source_is_bounded = 1;
+    goto sd_memory_copy_skip_data_check;
+  }
+
+  #ifdef SD_HAS_MEMORY_VIEW
+  /*
+    Then anything exporting a MemoryView (e.g., a Fiddle::Pointer with a size
+    or a Numo::NArray). The view is held until the copy is done.
+   */
+  if (rb_memory_view_available_p(sd_source)) {
+    if (rb_memory_view_get(sd_source, &source_view, RUBY_MEMORY_VIEW_SIMPLE)) {
+      /* Views without strides are contiguous (and may not have a shape) */
+      if (!source_view.strides || rb_memory_view_is_contiguous(&source_view)) {
+        source_pointer    = source_view.data;
+        source_size       = (size_t)source_view.byte_size;
+        source_is_bounded = 1;
+        source_is_view    = 1;
+        goto sd_memory_copy_skip_data_check;
+      }
+      rb_memory_view_release(&source_view);
+    }
+  }
+  #endif
+
+  /*
+    Otherwise, try to get an address from the object, if possible. Then use
+    that address and don't extract it from the Data object or what have you.
+   */
+  {
+    VALUE source_address = rb_check_funcall(sd_source, kSD_ID_ADDRESS, 0, 0);
+    if (source_address != Qundef && RTEST(rb_obj_is_kind_of(source_address, rb_cNumeric))) {
+      source_pointer = (uint8_t *)SD_NUM_TO_INTPTR_T(source_address);
+      goto sd_memory_copy_check_bytesize;
+    }
+  }
+
+  if (RB_TYPE_P(sd_source, T_DATA)) {
+    /* Otherwise extract a pointer from the object if it's a Data object */
+    source_pointer = ((const uint8_t *)DATA_PTR(sd_source));
+    source_is_data = 1;
+  } else if (RTEST(rb_obj_is_kind_of(sd_source, rb_cNumeric))) {
+    /* Otherwise, if it's a Numeric, try to convert what is assumed to be an
+      address to a pointer */
+    source_pointer = (uint8_t *)SD_NUM_TO_INTPTR_T(sd_source);
+  } else {
+    rb_raise(rb_eTypeError,
+      "Source object must be type of numeric (address) or Data- got %s",
+      rb_obj_classname(sd_source));
+  }
+
+sd_memory_copy_check_bytesize: /* skip from address check */
+  /*
+    If the source responds to bytesize, check if the copy is within bounds for
+    the source, otherwise optionally emit a warning that bounds checking
+    doesn't work for this source.
+   */
+  {
+    VALUE sd_source_size = rb_check_funcall(sd_source, kSD_ID_BYTESIZE, 0, 0);
+    if (sd_source_size != Qundef) {
+      source_size       = NUM2SIZET(sd_source_size);
+      source_is_bounded = 1;
+    }
+    #ifdef SD_WARN_ON_NO_BYTESIZE_METHOD
+    else if (source_is_data) {
+      rb_warning(
+        "Copying from Data object pointer %p that does not respond to #bytesize"
+        " -- this operation is not bounds-checked.",
+        source_pointer);
+    }
+    #endif
+  }
+
+  #ifdef SD_WARN_ON_IMPLICIT_COPY_SIZE
+  if (!RTEST(sd_byte_size) && !source_is_data) {
+    rb_warning(
+      "Copying %zu bytes from non-Data memory address %p without explicit size",
+      byte_size,
+      source_pointer);
+  }
+  #endif
+
+sd_memory_copy_skip_data_check: /* skip from Memory and MemoryView sources */
+  /*
+    Check if the source pointer is NULL -- error if it is (the destination
+    pointer is checked by sd_check_null_block above) -- and whether the copy
+    is in bounds of the source, if its size is known.
+   */
+  if (source_pointer == NULL || (source_is_bounded &&
+      (source_offset > source_size
+       || (source_offset + byte_size) > source_size
+       || (source_offset + byte_size) < source_offset))) {
+    #ifdef SD_HAS_MEMORY_VIEW
+    if (source_is_view) {
+      rb_memory_view_release(&source_view);
+    }
+    #endif
+    if (source_pointer == NULL) {
+      rb_raise(rb_eArgError, "Source pointer is NULL");
+    }
+    rb_raise(rb_eRangeError, "Attempt to copy out of source bounds");
+  }
+
+  source_pointer += source_offset;
+
+  #ifdef SD_VERBOSE_COPY_LOG
+  /*
+    Emit some debugging info just in case things go completely haywire and you
+    really need to know what's going on.
+   */
+  fprintf(stderr,
+    "# copy! ----------------------------------------\n"
+    "#  destination_pointer = %p"             "\n"
+    "#  source_pointer      = %p"             "\n"
+    "#  destination_offset  = %zu"            "\n"
+    "#  source_offset       = %zu"            "\n"
+    "#  byte_size           = %zu"            "\n"
+    "#  self_byte_size      = %zu"            "\n"
+    "#  source.class        = %s"             "\n"
+    "#  self.class          = %s"             "\n"
+    "# --------------------------------------- /copy!\n",
+    destination_pointer - destination_offset,
+    source_pointer - source_offset,
+    destination_offset,
+    source_offset,
+    byte_size,
+    self_byte_size,
+    rb_obj_classname(sd_source),
+    rb_obj_classname(self));
+  #endif
+
+  /* And skip a copy if we can */
+  if (byte_size == 0 || source_pointer == destination_pointer) {
+    #ifdef SD_HAS_MEMORY_VIEW
+    if (source_is_view) {
+      rb_memory_view_release(&source_view);
+    }
+    #endif
+    return self;
+  }
+
+  sd_stats.bytes_copied += byte_size;
+  if (SD_PROBE_ENABLED(copy)) {
+    SD_PROBE4(copy, destination_pointer, source_pointer, byte_size,
+      rb_obj_classname(self));
+  }
+
+  op.kind         = SD_BULK_MOVE;
+  op.destination  = destination_pointer;
+  op.source       = source_pointer;
+  op.size         = byte_size;
+
+  #ifdef SD_HAS_MEMORY_VIEW
+  if (source_is_view) {
+    /* Release the view even if the copy is interrupted */
+    sd_copy_view_t copy = { &op, self_data, &source_view };
+    rb_ensure(sd_copy_view_run, (VALUE)&copy, sd_copy_view_release, (VALUE)&copy);
+    RB_GC_GUARD(sd_source);
+    return self;
+  }
+  #endif
+
+  sd_bulk_op_run(&op, self_data, source_block);
+
+  RB_GC_GUARD(sd_source);
+  return self;
+}
+
+/*
+  call-seq:
+      fill!(byte, offset = 0, length = nil) => self
+
+  Sets length bytes of the block starting at offset to byte, an Integer whose
+  low 8 bits are used. If length is nil, it fills the rest of the block. Large
+  fills release the GVL (see ::nogvl_threshold).
+
+  Raises a RangeError if the range is outside the block.
+ */
+static VALUE sd_memory_fill(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_byte, sd_offset, sd_length;
+  sd_bulk_op_t op;
+  size_t offset;
+
+  rb_scan_args(argc, argv, "12", &sd_byte, &sd_offset, &sd_length);
+  sd_check_writable(self, block);
+
+  offset = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  if (offset > block->bytesize) {
+    rb_raise(rb_eRangeError, "Offset %zu is out of bounds (bytesize: %zu)",
+      offset, block->bytesize);
+  }
+
+  op.kind   = SD_BULK_FILL;
+  op.value  = (int)(NUM2INT(sd_byte) & 0xFF);
+  op.size   = RTEST(sd_length) ? NUM2SIZET(sd_length) : block->bytesize - offset;
+  op.source = NULL;
+
+  /* A zero-length fill is fine anywhere up to the end of the block, which
+     sd_check_block_bounds rejects */
+  if (op.size > 0) {
+    sd_check_block_bounds(block, offset, op.size);
+    sd_check_null_block(block);
+    op.destination = (uint8_t *)block->data + offset;
+    sd_bulk_op_run(&op, block, NULL);
+  }
+
+  return self;
+}
+
+/*
+  call-seq:
+      compare(other, offset = 0, other_offset = 0, length = nil) => Integer
+
+  Compares length bytes of the block starting at offset with length bytes of
+  other, another Memory object, starting at other_offset, as memcmp does.
+  Returns -1, 0, or 1 if the receiver's bytes are less than, equal to, or
+  greater than other's. If length is nil, it compares as many bytes as remain
+  in the smaller of the two ranges. Large comparisons release the GVL (see
+  ::nogvl_threshold).
+
+  Raises a RangeError if either range is outside its block.
+ */
+static VALUE sd_memory_compare(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  sd_memory_t *other;
+  VALUE sd_other, sd_offset, sd_other_offset, sd_length;
+  size_t offset, other_offset;
+  sd_bulk_op_t op;
+
+  rb_scan_args(argc, argv, "13", &sd_other, &sd_offset, &sd_other_offset, &sd_length);
+
+  if (!rb_typeddata_is_kind_of(sd_other, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "Other must be Memory, but got %s",
+      rb_obj_classname(sd_other));
+  }
+
+  other         = sd_memory_get(sd_other);
+  offset        = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  other_offset  = RTEST(sd_other_offset) ? NUM2SIZET(sd_other_offset) : 0;
+
+  if (offset > block->bytesize || other_offset > other->bytesize) {
+    rb_raise(rb_eRangeError, "Offset is out of bounds");
+  }
+
+  if (RTEST(sd_length)) {
+    op.size = NUM2SIZET(sd_length);
+  } else {
+    op.size = block->bytesize - offset;
+    if (other->bytesize - other_offset < op.size) {
+      op.size = other->bytesize - other_offset;
+    }
+  }
+
+  /* Zero-length ranges compare equal anywhere up to the end of either block,
+     which sd_check_block_bounds rejects */
+  if (op.size == 0) {
+    return INT2FIX(0);
+  }
+
+  sd_check_block_bounds(block, offset, op.size);
+  sd_check_block_bounds(other, other_offset, op.size);
+
+  sd_check_null_block(block);
+  sd_check_null_block(other);
+
+  op.kind         = SD_BULK_COMPARE;
+  op.destination  = (uint8_t *)block->data + offset;
+  op.source       = (const uint8_t *)other->data + other_offset;
+  op.value        = 0;
+  sd_bulk_op_run(&op, block, other);
+
+  RB_GC_GUARD(sd_other);
+  return INT2FIX(op.value < 0 ? -1 : (op.value > 0 ? 1 : 0));
+}
+
+/*
+  call-seq:
+      copy_strided!(source, element_size, count, destination_offset, destination_stride, source_offset, source_stride) => self
+
+  Copies count elements of element_size bytes each from the source Memory
+  object into the receiver. Elements are read starting at source_offset and
+  stepping source_stride bytes, and written starting at destination_offset and
+  stepping destination_stride bytes. This can be used to gather a single
+  member out of an array of structs or scatter it back in.
+
+  Both ranges are bounds-checked in full before anything is copied. If both
+  strides equal the element size, this is the same as a single copy!.
+
+  === Exceptions
+
+  - Raises a TypeError if the source isn't a Memory object.
+  - Raises a RangeError if either range falls outside its block.
+  - Raises an ArgumentError if either stride is zero.
+ */
+static VALUE sd_memory_copy_strided(VALUE self, VALUE sd_source, VALUE sd_element_size,
+  VALUE sd_count, VALUE sd_destination_offset, VALUE sd_destination_stride,
+  VALUE sd_source_offset, VALUE sd_source_stride)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  const sd_memory_t *source;
+  const size_t element_size       = NUM2SIZET(sd_element_size);
+  const size_t count              = NUM2SIZET(sd_count);
+  const size_t destination_offset = NUM2SIZET(sd_destination_offset);
+  const size_t source_offset      = NUM2SIZET(sd_source_offset);
+  const size_t destination_stride = sd_get_stride(sd_destination_stride, element_size);
+  const size_t source_stride      = sd_get_stride(sd_source_stride, element_size);
+  uint8_t *destination_pointer;
+  const uint8_t *source_pointer;
+  size_t index;
+
+  if (!rb_typeddata_is_kind_of(sd_source, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "Source must be Memory, but got %s",
+      rb_obj_classname(sd_source));
+  }
+
+  source = sd_memory_get(sd_source);
+
+  sd_check_writable(self, block);
+
+  if (count == 0 || element_size == 0) {
+    return self;
+  }
+
+  sd_check_block_range(block, destination_offset, count, destination_stride, element_size);
+  sd_check_block_range(source, source_offset, count, source_stride, element_size);
+  sd_check_null_block(block);
+  sd_check_null_block(source);
+
+  destination_pointer = (uint8_t *)block->data + destination_offset;
+  source_pointer      = (const uint8_t *)source->data + source_offset;
+
+  if (destination_stride == element_size && source_stride == element_size) {
+    memmove(destination_pointer, source_pointer, element_size * count);
+    return self;
+  }
+
+  for (index = 0; index < count; ++index) {
+    memmove(destination_pointer, source_pointer, element_size);
+    destination_pointer += destination_stride;
+    source_pointer      += source_stride;
+  }
+
+  return self;
+}
+
+/*
+  call-seq:
+      to_s(null_terminated = true) => String
+
+  Gets a string representation of the contents of this block. If null_terminated
+  is true (or nil), the returned string will end before the first null
+  character.
+ */
+static VALUE sd_memory_to_s(int argc, VALUE *argv, VALUE self)
+{
+  VALUE null_terminated;
+  sd_memory_t *block = sd_memory_get(self);
+  size_t byte_size = block->bytesize;
+  const char *data = block->data;
+
+  sd_check_null_block(block);
+
+  rb_scan_args(argc, argv, "01", &null_terminated);
+
+  if (null_terminated == Qnil || RTEST(null_terminated)) {
+    byte_size = sd_strnlen((const uint8_t *)data, byte_size);
+  }
+
+  return rb_str_new(data, byte_size);
+}
+
+/*
+  call-seq:
+      address => Integer
+
+  Gets the address of this memory block as an Integer.
+ */
+static VALUE sd_memory_address(VALUE self)
+{
+  return SD_UINTPTR_T_TO_NUM((uintptr_t)sd_memory_get(self)->data);
+}
+
+/*
+  call-seq:
+      bytesize => Integer
+
+  The size in bytes of a memory block.
+ */
+static VALUE sd_memory_bytesize(VALUE self)
+{
+  return SIZET2NUM(sd_memory_get(self)->bytesize);
+}
+
+/*
+  call-seq:
+      alignment => Integer
+
+  The alignment in bytes of a memory block.
+ */
+static VALUE sd_memory_alignment(VALUE self)
+{
+  return SIZET2NUM(sd_memory_get(self)->alignment);
+}
+
+/*
+  call-seq:
+      readonly? => true or false
+
+  Whether the block is read-only, as blocks mapped with :read are (see
+  ::__map__). Methods that write to a read-only block raise a RuntimeError.
+ */
+static VALUE sd_memory_readonly(VALUE self)
+{
+  return sd_memory_get(self)->readonly ? Qtrue : Qfalse;
+}
+
+/*
+  call-seq:
+      __readonly_view_of__(memory) => self
+
+  Marks the receiver read-only if memory is. Used by wrappers created in Ruby
+  around part of another block (e.g., struct array elements).
+ */
+static VALUE sd_memory_readonly_view_of(VALUE self, VALUE sd_memory)
+{
+  if (sd_memory_get(sd_memory)->readonly) {
+    sd_memory_get(self)->readonly = true;
+  }
+  return self;
+}
+
+/*
+  State for sd_memory_each_view, passed through rb_ensure.
+ */
+typedef struct s_sd_each_view {
+  VALUE   self;
+  VALUE   view;
+  size_t  stride;
+  size_t  count;
+} sd_each_view_t;
+
+static VALUE sd_memory_each_view_body(VALUE arg)
+{
+  const sd_each_view_t *state = (const sd_each_view_t *)arg;
+  sd_memory_t *const block = sd_memory_get(state->self);
+  sd_memory_t *const view = sd_memory_get(state->view);
+  size_t index;
+
+  for (index = 0; index < state->count; ++index) {
+    const size_t offset = index * state->stride;
+    /*
+      Check bounds on every iteration, since the block may be freed or
+      reallocated by the block being yielded to.
+     */
+    sd_check_block_bounds(block, offset, view->bytesize);
+    sd_check_null_block(block);
+    view->data = (uint8_t *)block->data + offset;
+    rb_yield_values(2, state->view, SIZET2NUM(index));
+  }
+
+  return state->self;
+}
+
+static VALUE sd_memory_each_view_ensure(VALUE arg)
+{
+  const sd_each_view_t *state = (const sd_each_view_t *)arg;
+  sd_memory_get(state->view)->data = NULL;
+  return Qnil;
+}
+
+/*
+  call-seq:
+      __each_view__(view, stride, count) { |view, index| ... } => self
+
+  Points view at each of count elements of the receiver, stride bytes apart,
+  and yields it along with the element's index. The same view object is
+  yielded for every element, so it must not be kept around past the iteration
+  it was yielded for. Once iteration ends, the view is left pointing at NULL.
+
+  The view must be a Memory object that doesn't own its block. Its bytesize is
+  used as the size of each element.
+ */
+static VALUE sd_memory_each_view(VALUE self, VALUE sd_view, VALUE sd_stride, VALUE sd_count)
+{
+  sd_each_view_t state;
+
+  rb_need_block();
+
+  if (!rb_typeddata_is_kind_of(sd_view, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "View must be Memory, but got %s",
+      rb_obj_classname(sd_view));
+  } else if (sd_memory_get(sd_view)->free_func || sd_memory_get(sd_view)->pool) {
+    rb_raise(rb_eArgError, "View must not own its memory");
+  }
+
+  rb_check_frozen(sd_view);
+
+  state.self    = self;
+  state.view    = sd_view;
+  state.stride  = NUM2SIZET(sd_stride);
+  state.count   = NUM2SIZET(sd_count);
+
+  return rb_ensure(sd_memory_each_view_body, (VALUE)&state,
+                   sd_memory_each_view_ensure, (VALUE)&state);
+}
+
+/*
+  call-seq:
+      __rebase_views__(views, old_address, old_bytesize) => views
+
+  Moves views (an Array of Memory objects that don't own their blocks) that
+  pointed into old_bytesize bytes at old_address so they point to the same
+  offsets in the receiver's block. Views that pointed outside that range, or
+  whose offset is past the end of the receiver's block, are left pointing at
+  NULL, as is every view if the receiver's block is NULL. Used after a struct
+  vector's block is reallocated so elements fetched before the reallocation
+  stay valid, and after it's freed so none of them do.
+ */
+static VALUE sd_memory_rebase_views(VALUE self, VALUE sd_views, VALUE sd_old_address,
+  VALUE sd_old_bytesize)
+{
+  const sd_memory_t *const block = sd_memory_get(self);
+  const uintptr_t old_address = (uintptr_t)SD_NUM_TO_INTPTR_T(sd_old_address);
+  const size_t old_bytesize = NUM2SIZET(sd_old_bytesize);
+  long index;
+
+  Check_Type(sd_views, T_ARRAY);
+
+  for (index = 0; index < RARRAY_LEN(sd_views); ++index) {
+    const VALUE sd_view = RARRAY_AREF(sd_views, index);
+    sd_memory_t *view;
+    uintptr_t address;
+    size_t offset;
+
+    if (!rb_typeddata_is_kind_of(sd_view, &sd_memory_type)) {
+      rb_raise(rb_eTypeError, "View must be Memory, but got %s",
+        rb_obj_classname(sd_view));
+    }
+
+    view = sd_memory_get(sd_view);
+    if (view->free_func || view->pool || view->data == NULL) {
+      continue;
+    }
+
+    address = (uintptr_t)view->data;
+    offset  = (size_t)(address - old_address);
+    if (address < old_address || offset >= old_bytesize || block->data == NULL ||
+        offset + view->bytesize > block->bytesize) {
+      view->data = NULL;
+    } else {
+      view->data = (uint8_t *)block->data + offset;
+    }
+  }
+
+  return sd_views;
+}
+
+/*
+  call-seq:
+      align_size(size_or_offset, alignment = nil) => Integer
+
+  Aligns a given size or offset to a specific alignment. If no alignment is
+  provided, it defaults to the size of a pointer on the architecture the
+  extension was compiled for.
+
+  See Snow::Memory::SIZEOF_VOID_POINTER for the size of a pointer.
+
+  Raises a RangeError if the alignment is not a power of two. In this case, 1
+  is considered a valid power of two.
+ */
+static VALUE sd_align_size(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_alignment;
+  VALUE sd_size;
+  size_t alignment = sizeof(void *);
+  rb_scan_args(argc, argv, "11", &sd_size, &sd_alignment);
+  if (RTEST(sd_alignment)) {
+    alignment = NUM2SIZET(sd_alignment);
+    if (!is_power_of_two(alignment)) {
+      rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not"
+        " a power of two", alignment);
+    }
+  }
+  return SIZET2NUM(align_size(NUM2SIZET(sd_size), alignment));
+}
+
+/*
+  Marks the struct classes referenced by a layout's members.
+ */
+static void sd_layout_mark(void *ptr)
+{
+  const sd_layout_t *layout = (const sd_layout_t *)ptr;
+  size_t index;
+
+  for (index = 0; index < layout->count; ++index) {
+    rb_gc_mark(layout->members[index].klass);
+  }
+}
+
+static void sd_layout_free(void *ptr)
+{
+  sd_layout_t *layout = (sd_layout_t *)ptr;
+
+  if (layout->method_index) {
+    st_free_table(layout->method_index);
+  }
+
+  xfree(layout->members);
+  xfree(layout);
+}
+
+static const rb_data_type_t sd_layout_type = {
+  "Snow::CStruct::Layout",
+  { sd_layout_mark, sd_layout_free, 0, },
+  0, 0,
+  RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/*
+  Returns the layout registered for the given class or its nearest ancestor
+  with one. Returns NULL if there is none.
+ */
+static const sd_layout_t *sd_find_layout(VALUE klass)
+{
+  for (; RTEST(klass); klass = rb_class_superclass(klass)) {
+    if (rb_ivar_defined(klass, kSD_ID_LAYOUT)) {
+      return (const sd_layout_t *)DATA_PTR(rb_ivar_get(klass, kSD_ID_LAYOUT));
+    }
+  }
+
+  return NULL;
+}
+
+/*
+  Returns the member whose getter or setter is currently being called on self.
+  The member's layout is cached in self's sd_memory_t the first time it's
+  looked up.
+ */
+static const sd_member_t *sd_get_called_member(VALUE self, sd_memory_t *block)
+{
+  const sd_layout_t *layout = block->layout;
+  st_data_t index;
+
+  if (!layout) {
+    layout = block->layout = sd_find_layout(CLASS_OF(self));
+  }
+
+  if (!layout || !st_lookup(layout->method_index, (st_data_t)rb_frame_this_func(), &index)) {
+    rb_raise(rb_eRuntimeError, "No member layout for method in %s",
+      rb_obj_classname(self));
+  }
+
+  return &layout->members[index];
+}
+
+/*
+  Returns the offset of the element at the given index of a member, raising a
+  RangeError if the index isn't within the member's length, then checks that
+  the element is within self's block.
+ */
+static size_t sd_member_element_offset(const sd_memory_t *block, const sd_member_t *member, VALUE sd_index)
+{
+  const long index = NUM2LONG(sd_index);
+  size_t offset;
+
+  if (index < 0 || (size_t)index >= member->length) {
+    rb_raise(rb_eRangeError,
+      "Index %ld for %s is out of range: must be in 0...%zu",
+      index, rb_id2name(member->name), member->length);
+  }
+
+  offset = member->offset + (size_t)index * member->type_size;
+  sd_check_block_bounds(block, offset, member->type_size);
+  sd_check_null_block(block);
+  return offset;
+}
+
+/*
+  If parent lives in a struct vector, ties wrapper, a wrapper of one of
+  parent's members, to the same vector so it's moved or released along with
+  the vector's block.
+ */
+static void sd_track_member_view(VALUE parent, VALUE wrapper)
+{
+  const VALUE root = rb_attr_get(parent, kSD_IVAR_VIEW_ROOT);
+  if (!NIL_P(root)) {
+    rb_ivar_set(wrapper, kSD_IVAR_VIEW_ROOT, root);
+    rb_funcall(root, kSD_ID_TRACK_VIEW, 1, wrapper);
+  }
+}
+
+/*
+  call-seq:
+      get_<member>(index = 0) => value
+
+  Gets the value of a struct member at the given index. For members whose type
+  is another struct, this returns a new instance of that struct wrapping the
+  member's memory.
+ */
+static VALUE sd_struct_get_member(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  const sd_member_t *member = sd_get_called_member(self, block);
+  const uint8_t *data;
+  VALUE wrapper;
+
+  if (argc > 1) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0..1)", argc);
+  }
+
+  data = (const uint8_t *)block->data +
+    sd_member_element_offset(block, member, argc ? argv[0] : INT2FIX(0));
+
+  switch (member->type) {
+  case SD_TYPE_STRUCT:
+    wrapper = sd_wrap_memory(member->klass, (void *)data, member->type_size,
+      member->type_alignment, SD_DO_NOT_FREE_MEMORY);
+    /* Keep the struct being wrapped alive as long as the wrapper is */
+    rb_ivar_set(wrapper, kSD_IVAR_BASE_MEMORY, self);
+    sd_track_member_view(self, wrapper);
+    /* Members of a read-only mapped struct are read-only too */
+    sd_memory_get(wrapper)->readonly = block->readonly;
+    return wrapper;
+  case SD_TYPE_INT8_T:             return SD_INT8_TO_NUM(*(const int8_t *)data);
+  case SD_TYPE_INT16_T:            return SD_INT16_TO_NUM(*(const int16_t *)data);
+  case SD_TYPE_INT32_T:            return SD_INT32_TO_NUM(*(const int32_t *)data);
+  case SD_TYPE_INT64_T:            return SD_INT64_TO_NUM(*(const int64_t *)data);
+  case SD_TYPE_UINT8_T:            return SD_UINT8_TO_NUM(*(const uint8_t *)data);
+  case SD_TYPE_UINT16_T:           return SD_UINT16_TO_NUM(*(const uint16_t *)data);
+  case SD_TYPE_UINT32_T:           return SD_UINT32_TO_NUM(*(const uint32_t *)data);
+  case SD_TYPE_UINT64_T:           return SD_UINT64_TO_NUM(*(const uint64_t *)data);
+  case SD_TYPE_SIZE_T:             return SD_SIZE_T_TO_NUM(*(const size_t *)data);
+  case SD_TYPE_PTRDIFF_T:          return SD_PTRDIFF_T_TO_NUM(*(const ptrdiff_t *)data);
+  case SD_TYPE_INTPTR_T:           return SD_INTPTR_T_TO_NUM(*(const intptr_t *)data);
+  case SD_TYPE_UINTPTR_T:          return SD_UINTPTR_T_TO_NUM(*(const uintptr_t *)data);
+  case SD_TYPE_LONG:               return SD_LONG_TO_NUM(*(const long *)data);
+  case SD_TYPE_LONG_LONG:          return SD_LONG_LONG_TO_NUM(*(const long long *)data);
+  case SD_TYPE_UNSIGNED_LONG:      return SD_UNSIGNED_LONG_TO_NUM(*(const unsigned long *)data);
+  case SD_TYPE_UNSIGNED_LONG_LONG: return SD_UNSIGNED_LONG_LONG_TO_NUM(*(const unsigned long long *)data);
+  case SD_TYPE_FLOAT:              return SD_FLOAT_TO_NUM(*(const float *)data);
+  case SD_TYPE_DOUBLE:             return SD_DOUBLE_TO_NUM(*(const double *)data);
+  case SD_TYPE_INT:                return SD_INT_TO_NUM(*(const int *)data);
+  case SD_TYPE_UNSIGNED_INT:       return SD_UNSIGNED_INT_TO_NUM(*(const unsigned int *)data);
+  case SD_TYPE_SHORT:              return SD_SHORT_TO_NUM(*(const short *)data);
+  case SD_TYPE_UNSIGNED_SHORT:     return SD_UNSIGNED_SHORT_TO_NUM(*(const unsigned short *)data);
+  case SD_TYPE_CHAR:               return SD_CHAR_TO_NUM(*(const char *)data);
+  case SD_TYPE_UNSIGNED_CHAR:      return SD_UNSIGNED_CHAR_TO_NUM(*(const unsigned char *)data);
+  case SD_TYPE_SIGNED_CHAR:        return SD_SIGNED_CHAR_TO_NUM(*(const signed char *)data);
+  }
+
+  return Qnil;
+}
+
+/*
+  call-seq:
+      set_<member>(value, index = 0) => value
+
+  Sets the value of a struct member at the given index and returns the value.
+  For members whose type is another struct, the value must be a Memory object
+  at least as large as the member's type, and its contents are copied into the
+  member.
+ */
+static VALUE sd_struct_set_member(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  const sd_member_t *member = sd_get_called_member(self, block);
+  const sd_memory_t *source;
+  uint8_t *data;
+  VALUE sd_value;
+
+  if (argc < 1 || argc > 2) {
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1..2)", argc);
+  }
+
+  sd_value = argv[0];
+  data = (uint8_t *)block->data +
+    sd_member_element_offset(block, member, argc > 1 ? argv[1] : INT2FIX(0));
+  sd_check_writable(self, block);
+
+  switch (member->type) {
+  case SD_TYPE_STRUCT:
+    if (!rb_typeddata_is_kind_of(sd_value, &sd_memory_type)) {
+      rb_raise(rb_eTypeError, "Invalid value type, must be Memory, but got %s",
+        rb_obj_classname(sd_value));
+    }
+    source = sd_memory_get(sd_value);
+    sd_check_null_block(source);
+    if (source->bytesize < member->type_size) {
+      rb_raise(rb_eRangeError, "Attempt to copy out of source bounds");
+    }
+    if (source->data != data) {
+      memmove(data, source->data, member->type_size);
+    }
+    break;
+  case SD_TYPE_INT8_T:             *(int8_t *)data = SD_NUM_TO_INT8(sd_value); break;
+  case SD_TYPE_INT16_T:            *(int16_t *)data = SD_NUM_TO_INT16(sd_value); break;
+  case SD_TYPE_INT32_T:            *(int32_t *)data = SD_NUM_TO_INT32(sd_value); break;
+  case SD_TYPE_INT64_T:            *(int64_t *)data = SD_NUM_TO_INT64(sd_value); break;
+  case SD_TYPE_UINT8_T:            *(uint8_t *)data = SD_NUM_TO_UINT8(sd_value); break;
+  case SD_TYPE_UINT16_T:           *(uint16_t *)data = SD_NUM_TO_UINT16(sd_value); break;
+  case SD_TYPE_UINT32_T:           *(uint32_t *)data = SD_NUM_TO_UINT32(sd_value); break;
+  case SD_TYPE_UINT64_T:           *(uint64_t *)data = SD_NUM_TO_UINT64(sd_value); break;
+  case SD_TYPE_SIZE_T:             *(size_t *)data = SD_NUM_TO_SIZE_T(sd_value); break;
+  case SD_TYPE_PTRDIFF_T:          *(ptrdiff_t *)data = SD_NUM_TO_PTRDIFF_T(sd_value); break;
+  case SD_TYPE_INTPTR_T:           *(intptr_t *)data = SD_NUM_TO_INTPTR_T(sd_value); break;
+  case SD_TYPE_UINTPTR_T:          *(uintptr_t *)data = SD_NUM_TO_UINTPTR_T(sd_value); break;
+  case SD_TYPE_LONG:               *(long *)data = SD_NUM_TO_LONG(sd_value); break;
+  case SD_TYPE_LONG_LONG:          *(long long *)data = SD_NUM_TO_LONG_LONG(sd_value); break;
+  case SD_TYPE_UNSIGNED_LONG:      *(unsigned long *)data = SD_NUM_TO_UNSIGNED_LONG(sd_value); break;
+  case SD_TYPE_UNSIGNED_LONG_LONG: *(unsigned long long *)data = SD_NUM_TO_UNSIGNED_LONG_LONG(sd_value); break;
+  case SD_TYPE_FLOAT:              *(float *)data = SD_NUM_TO_FLOAT(sd_value); break;
+  case SD_TYPE_DOUBLE:             *(double *)data = SD_NUM_TO_DOUBLE(sd_value); break;
+  case SD_TYPE_INT:                *(int *)data = SD_NUM_TO_INT(sd_value); break;
+  case SD_TYPE_UNSIGNED_INT:       *(unsigned int *)data = SD_NUM_TO_UNSIGNED_INT(sd_value); break;
+  case SD_TYPE_SHORT:              *(short *)data = SD_NUM_TO_SHORT(sd_value); break;
+  case SD_TYPE_UNSIGNED_SHORT:     *(unsigned short *)data = SD_NUM_TO_UNSIGNED_SHORT(sd_value); break;
+  case SD_TYPE_CHAR:               *(char *)data = SD_NUM_TO_CHAR(sd_value); break;
+  case SD_TYPE_UNSIGNED_CHAR:      *(unsigned char *)data = SD_NUM_TO_UNSIGNED_CHAR(sd_value); break;
+  case SD_TYPE_SIGNED_CHAR:        *(signed char *)data = SD_NUM_TO_SIGNED_CHAR(sd_value); break;
+  }
+
+  return sd_value;
+}
+
+/*
+  Returns the type info for a primitive type name, or NULL if the name isn't
+  that of a primitive type.
+ */
+static const sd_type_info_t *sd_find_type_info(VALUE sd_type)
+{
+  const sd_type_info_t *info;
+  const char *name = rb_id2name(SYM2ID(rb_to_symbol(sd_type)));
+
+  for (info = sd_type_infos; info->name; ++info) {
+    if (strcmp(info->name, name) == 0) {
+      return info;
+    }
+  }
+
+  return NULL;
+}
+
+/*
+  call-seq:
+      __define_member__(name, type, offset, length, type_size, type_klass = nil) => self
+
+  Registers a member with the receiving struct class's layout and defines its
+  get_<name> and set_<name> methods. type must be the name of a primitive type
+  or, if type_klass is given, the name the Memory subclass type_klass was added
+  to CStruct under. This is called by CStruct::StructBase when building struct
+  classes and shouldn't be called otherwise.
+ */
+static VALUE sd_struct_define_member(int argc, VALUE *argv, VALUE self)
+{
+  VALUE sd_name, sd_type, sd_offset, sd_length, sd_type_size, sd_type_klass;
+  VALUE sd_layout;
+  sd_layout_t *layout;
+  sd_member_t *member;
+  const sd_type_info_t *info;
+  st_data_t index;
+  const char *name;
+
+  rb_scan_args(argc, argv, "51",
+    &sd_name, &sd_type, &sd_offset, &sd_length, &sd_type_size, &sd_type_klass);
+
+  if (rb_ivar_defined(self, kSD_ID_LAYOUT)) {
+    sd_layout = rb_ivar_get(self, kSD_ID_LAYOUT);
+  } else {
+    /* The layout is a hidden object, only reachable through the class */
+    sd_layout = TypedData_Make_Struct(0, sd_layout_t, &sd_layout_type, layout);
+    layout->method_index = st_init_numtable();
+    rb_ivar_set(self, kSD_ID_LAYOUT, sd_layout);
+  }
+  layout = (sd_layout_t *)DATA_PTR(sd_layout);
+
+  if (layout->count == layout->capacity) {
+    layout->capacity = layout->capacity ? layout->capacity * 2 : 8;
+    REALLOC_N(layout->members, sd_member_t, layout->capacity);
+  }
+
+  member            = &layout->members[layout->count];
+  name              = rb_id2name(SYM2ID(rb_to_symbol(sd_name)));
+  member->name      = rb_intern(name);
+  member->getter    = rb_intern_str(rb_sprintf("get_%s", name));
+  member->setter    = rb_intern_str(rb_sprintf("set_%s", name));
+  member->offset    = NUM2SIZET(sd_offset);
+  member->length    = NUM2SIZET(sd_length);
+  member->type_size = NUM2SIZET(sd_type_size);
+  member->klass     = Qnil;
+
+  if (RTEST(sd_type_klass)) {
+    member->type            = SD_TYPE_STRUCT;
+    member->type_alignment  = NUM2SIZET(rb_const_get(sd_type_klass, rb_intern("ALIGNMENT")));
+    member->klass           = sd_type_klass;
+  } else if ((info = sd_find_type_info(sd_type))) {
+    if (info->size != member->type_size) {
+      rb_raise(rb_eArgError, "Size %zu given for %s does not match its size %zu",
+        member->type_size, info->name, info->size);
+    }
+    member->type            = info->type;
+    member->type_alignment  = info->size;
+  } else {
+    rb_raise(rb_eArgError, "Unknown member type %"PRIsVALUE, sd_type);
+  }
+
+  if (member->length < 1) {
+    rb_raise(rb_eArgError, "Invalid length for member %s: must be >= 1", name);
+  }
+
+  index = (st_data_t)layout->count;
+  st_insert(layout->method_index, (st_data_t)member->getter, index);
+  st_insert(layout->method_index, (st_data_t)member->setter, index);
+  layout->count += 1;
+  RB_OBJ_WRITTEN(sd_layout, Qundef, member->klass);
+
+  rb_define_method_id(self, member->getter, sd_struct_get_member, -1);
+  rb_define_method_id(self, member->setter, sd_struct_set_member, -1);
+
+  return self;
+}
+
+/*
+  Arenas
+ */
+
+#define SD_ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+#define SD_ARENA_CHUNK_ALIGNMENT    (64)
+
+typedef struct s_sd_arena_chunk {
+  struct s_sd_arena_chunk *next;
+  void                    *data;
+  size_t                  bytesize;
+} sd_arena_chunk_t;
+
+typedef struct s_sd_arena {
+  sd_arena_chunk_t  *chunks;      /* All chunks, in the order they're used. */
+  sd_arena_chunk_t  *current;     /* Chunk being allocated from, or NULL. */
+  size_t            offset;       /* Next free byte in current. */
+  size_t            chunk_size;
+  size_t            used;         /* Bytes handed out since the last reset. */
+  VALUE             wrappers;     /* Objects to invalidate on reset. */
+  VALUE             spare;        /* Empty array swapped with wrappers on reset. */
+  VALUE             views;        /* WeakMap of member wrappers of objects, or nil. */
+} sd_arena_t;
+
+static void sd_arena_dmark(void *ptr)
+{
+  rb_gc_mark(((sd_arena_t *)ptr)->wrappers);
+  rb_gc_mark(((sd_arena_t *)ptr)->spare);
+  rb_gc_mark(((sd_arena_t *)ptr)->views);
+}
+
+static void sd_arena_free_chunks(sd_arena_t *arena)
+{
+  sd_arena_chunk_t *chunk = arena->chunks;
+  while (chunk) {
+    sd_arena_chunk_t *const next = chunk->next;
+    com_free(chunk->data, chunk->bytesize, SD_ARENA_CHUNK_ALIGNMENT);
+    xfree(chunk);
+    chunk = next;
+  }
+  arena->chunks = NULL;
+  arena->current = NULL;
+  arena->offset = 0;
+  arena->used = 0;
+}
+
+static void sd_arena_dfree(void *ptr)
+{
+  sd_arena_free_chunks((sd_arena_t *)ptr);
+  xfree(ptr);
+}
+
+static size_t sd_arena_dsize(const void *ptr)
+{
+  const sd_arena_t *arena = (const sd_arena_t *)ptr;
+  const sd_arena_chunk_t *chunk;
+  size_t size = sizeof(*arena);
+  for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+    size += sizeof(*chunk) + chunk->bytesize;
+  }
+  return size;
+}
+
+static const rb_data_type_t sd_arena_type = {
+  "Snow::Arena",
+  { sd_arena_dmark, sd_arena_dfree, sd_arena_dsize, },
+  0, 0,
+  RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static sd_arena_t *sd_arena_get(VALUE self)
+{
+  return (sd_arena_t *)rb_check_typeddata(self, &sd_arena_type);
+}
+
+static VALUE sd_arena_alloc(VALUE klass)
+{
+  sd_arena_t *arena;
+  VALUE self = TypedData_Make_Struct(klass, sd_arena_t, &sd_arena_type, arena);
+  arena->chunk_size = SD_ARENA_DEFAULT_CHUNK_SIZE;
+  arena->wrappers = Qnil;
+  arena->spare = Qnil;
+  arena->views = Qnil;
+  return self;
+}
+
+/*
+  call-seq:
+      new(chunk_size = 65536) => arena
+
+  Creates a new, empty arena. Memory is allocated from chunks of chunk_size
+  bytes, or larger chunks for allocations that don't fit in one. No chunks are
+  allocated until the arena is first used.
+ */
+static VALUE sd_arena_initialize(int argc, VALUE *argv, VALUE self)
+{
+  sd_arena_t *const arena = sd_arena_get(self);
+  VALUE sd_chunk_size;
+
+  rb_scan_args(argc, argv, "01", &sd_chunk_size);
+
+  if (RTEST(sd_chunk_size)) {
+    arena->chunk_size = NUM2SIZET(sd_chunk_size);
+    if (arena->chunk_size == 0) {
+      rb_raise(rb_eArgError, "Chunk size must be 1 or greater");
+    }
+  }
+
+  RB_OBJ_WRITE(self, &arena->wrappers, rb_ary_new());
+  RB_OBJ_WRITE(self, &arena->spare, rb_ary_new());
+  return self;
+}
+
+/*
+  Returns the offset of the first address in chunk at or after offset that is
+  aligned to alignment, or SIZE_MAX if size bytes at that address don't fit in
+  the chunk.
+ */
+static size_t sd_arena_fit(const sd_arena_chunk_t *chunk, size_t offset, size_t size, size_t alignment)
+{
+  const uintptr_t base = (uintptr_t)chunk->data;
+  const uintptr_t aligned = (base + offset + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+  const size_t aligned_offset = (size_t)(aligned - base);
+
+  if (aligned_offset > chunk->bytesize || chunk->bytesize - aligned_offset < size) {
+    return SIZE_MAX;
+  }
+  return aligned_offset;
+}
+
+/*
+  Allocates size bytes aligned to alignment from the arena and returns them,
+  zeroed. Moves on to the next chunk, or allocates a new one after the current
+  chunk, if the current chunk can't fit the allocation.
+ */
+static void *sd_arena_allocate(sd_arena_t *arena, size_t size, size_t alignment)
+{
+  sd_arena_chunk_t *chunk = arena->current;
+  size_t offset = SIZE_MAX;
+  uint8_t *result;
+
+  if (chunk) {
+    offset = sd_arena_fit(chunk, arena->offset, size, alignment);
+    if (offset == SIZE_MAX && chunk->next) {
+      chunk = chunk->next;
+      offset = sd_arena_fit(chunk, 0, size, alignment);
+    }
+  } else if (arena->chunks) {
+    chunk = arena->chunks;
+    offset = sd_arena_fit(chunk, 0, size, alignment);
+  }
+
+  if (offset == SIZE_MAX) {
+    sd_arena_chunk_t *const fresh = ALLOC(sd_arena_chunk_t);
+    size_t chunk_size = arena->chunk_size;
+
+    if (size > SIZE_MAX - alignment) {
+      xfree(fresh);
+      rb_raise(rb_eRangeError, "Arena allocation of %zu bytes is too large", size);
+    }
+    if (chunk_size < size + alignment) {
+      chunk_size = size + alignment;
+    }
+
+    fresh->data = com_malloc(chunk_size, SD_ARENA_CHUNK_ALIGNMENT, SD_ZERO_MEMORY);
+    fresh->bytesize = chunk_size;
+
+    /* Keep any chunks after the current one around for later allocations. */
+    if (chunk) {
+      fresh->next = chunk->next;
+      chunk->next = fresh;
+    } else {
+      fresh->next = arena->chunks;
+      arena->chunks = fresh;
+    }
+
+    chunk = fresh;
+    offset = sd_arena_fit(chunk, 0, size, alignment);
+  }
+
+  result = (uint8_t *)chunk->data + offset;
+  arena->current = chunk;
+  arena->offset = offset + size;
+  arena->used += size;
+
+  memset(result, 0, size);
+  return result;
+}
+
+/*
+  call-seq:
+      __allocate__(bytesize, alignment) => Integer
+
+  Allocates a zeroed block of bytesize bytes from the arena and returns its
+  address. The block remains valid until the arena is reset or released.
+ */
+static VALUE sd_arena_allocate_m(VALUE self, VALUE sd_size, VALUE sd_alignment)
+{
+  sd_arena_t *const arena = sd_arena_get(self);
+  const size_t size = NUM2SIZET(sd_size);
+  const size_t alignment = NUM2SIZET(sd_alignment);
+
+  if (size == 0) {
+    rb_raise(rb_eArgError, "Block size must be 1 or greater");
+  } else if (!is_power_of_two(alignment)) {
+    rb_raise(rb_eArgError, "Alignment must be a power of two -- %zu is not a"
+      " power of two", alignment);
+  } else if (alignment > SD_ARENA_CHUNK_ALIGNMENT) {
+    rb_raise(rb_eArgError, "Alignment must be at most %d for arena allocations",
+      SD_ARENA_CHUNK_ALIGNMENT);
+  } else if (NIL_P(arena->wrappers)) {
+    rb_raise(rb_eRuntimeError, "Arena is not initialized");
+  }
+
+  return SD_INTPTR_T_TO_NUM((intptr_t)sd_arena_allocate(arena, size, alignment));
+}
+
+/*
+  call-seq:
+      __track__(memory) => memory
+
+  Ties a Memory object wrapping arena memory to the arena. The object keeps the
+  arena alive and is invalidated when the arena is reset or released.
+ */
+static VALUE sd_arena_track(VALUE self, VALUE sd_memory)
+{
+  sd_arena_t *const arena = sd_arena_get(self);
+
+  if (!rb_typeddata_is_kind_of(sd_memory, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "Expected Memory, got %s", rb_obj_classname(sd_memory));
+  }
+
+  RB_OBJ_WRITE(sd_memory, &sd_memory_get(sd_memory)->owner, self);
+  /* So wrappers of the object's members are tracked too (see __track_view__) */
+  rb_ivar_set(sd_memory, kSD_IVAR_VIEW_ROOT, self);
+  rb_ary_push(arena->wrappers, sd_memory);
+  return sd_memory;
+}
+
+/*
+  call-seq:
+      __track_view__(view) => view
+
+  Weakly ties a wrapper of a member of an object allocated from the arena (e.g.,
+  a nested struct member) to the arena, so it's nulled along with the object
+  when the arena is reset or released. Called by the struct member getters and
+  struct arrays for any object whose @__view_root__ is the arena.
+ */
+static VALUE sd_arena_track_view(VALUE self, VALUE sd_view)
+{
+  static ID id_aset = 0;
+  sd_arena_t *const arena = sd_arena_get(self);
+
+  if (!rb_typeddata_is_kind_of(sd_view, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "Expected Memory, got %s", rb_obj_classname(sd_view));
+  } else if (!id_aset) {
+    id_aset = rb_intern("[]=");
+  }
+
+  if (NIL_P(arena->views)) {
+    const VALUE weak_map = rb_const_get(rb_const_get(rb_cObject, rb_intern("ObjectSpace")),
+      rb_intern("WeakMap"));
+    RB_OBJ_WRITE(self, &arena->views, rb_class_new_instance(0, NULL, weak_map));
+  }
+
+  rb_funcall(arena->views, id_aset, 2, sd_view, sd_view);
+  return sd_view;
+}
+
+/* Returns an Array of the arena's tracked member wrappers, or nil. */
+static VALUE sd_arena_view_list(sd_arena_t *arena)
+{
+  return NIL_P(arena->views) ? Qnil : rb_funcallv(arena->views, rb_intern("keys"), 0, NULL);
+}
+
+/*
+  call-seq:
+      __wrap_new__(klass, bytesize, alignment) => Memory
+
+  Allocates bytesize bytes from the arena and returns a tracked Memory object
+  of the given class wrapping them. Saves the round trips through ::__wrap__
+  and __track__ for fixed-size objects like structs.
+ */
+static VALUE sd_arena_wrap_new(VALUE self, VALUE klass, VALUE sd_size, VALUE sd_alignment)
+{
+  const VALUE address = sd_arena_allocate_m(self, sd_size, sd_alignment);
+  const VALUE memory = sd_wrap_memory(klass, (void *)SD_NUM_TO_INTPTR_T(address),
+    NUM2SIZET(sd_size), NUM2SIZET(sd_alignment), SD_DO_NOT_FREE_MEMORY);
+  return sd_arena_track(self, memory);
+}
+
+/*
+  Raises a RuntimeError if any object handed out by the arena has a String
+  view, a MemoryView, or a GVL-free operation in progress, as the arena's
+  memory can't be freed or reused while those still point into it.
+ */
+static void sd_arena_check_unpinned(sd_arena_t *arena, const char *action)
+{
+  const VALUE lists[2] = { arena->wrappers, sd_arena_view_list(arena) };
+  long index;
+  int list;
+
+  for (list = 0; list < 2; ++list) {
+    if (NIL_P(lists[list])) {
+      continue;
+    }
+    for (index = 0; index < RARRAY_LEN(lists[list]); ++index) {
+      const sd_memory_t *const block = sd_memory_get(RARRAY_AREF(lists[list], index));
+      if (block->data && block->pinned) {
+        rb_raise(rb_eRuntimeError, "Cannot %s arena while views share its memory", action);
+      }
+    }
+  }
+}
+
+/*
+  Invalidates every object handed out by the arena. Objects are freed with
+  free! so subclasses can clear their own state (e.g., struct arrays drop their
+  cached element wrappers). Frozen objects and objects already freed are nulled
+  directly, as are wrappers of their members. Callers must check that no object
+  is pinned first.
+
+  The list of objects is swapped with an empty spare before invalidating them,
+  so anything allocated from the arena by a free! override is tracked as usual,
+  and the list is then cleared and kept as the next spare.
+ */
+static void sd_arena_invalidate(VALUE self, sd_arena_t *arena)
+{
+  static ID id_free = 0;
+  VALUE wrappers = arena->wrappers;
+  VALUE views;
+  long index;
+
+  if (NIL_P(wrappers)) {
+    return;
+  } else if (!id_free) {
+    id_free = rb_intern("free!");
+  }
+
+  /* spare is nil if a free! override raised during the last reset */
+  RB_OBJ_WRITE(self, &arena->wrappers, NIL_P(arena->spare) ? rb_ary_new() : arena->spare);
+  arena->spare = Qnil;
+
+  for (index = 0; index < RARRAY_LEN(wrappers); ++index) {
+    const VALUE wrapper = RARRAY_AREF(wrappers, index);
+    sd_memory_t *const block = sd_memory_get(wrapper);
+
+    if (!block->data) {
+      continue;
+    } else if (OBJ_FROZEN(wrapper)) {
+      block->data = 0;
+      block->bytesize = 0;
+    } else {
+      rb_funcallv(wrapper, id_free, 0, NULL);
+    }
+  }
+
+  rb_ary_clear(wrappers);
+  RB_OBJ_WRITE(self, &arena->spare, wrappers);
+
+  /* After the objects' free! calls, so e.g. struct arrays drop their cached
+     element wrappers themselves */
+  views = sd_arena_view_list(arena);
+  arena->views = Qnil;
+  for (index = 0; !NIL_P(views) && index < RARRAY_LEN(views); ++index) {
+    sd_memory_t *const block = sd_memory_get(RARRAY_AREF(views, index));
+    block->data = 0;
+    block->bytesize = 0;
+  }
+}
+
+/*
+  call-seq:
+      reset! => self
+
+  Invalidates every object allocated from the arena and makes its memory
+  available for reuse. Chunks are kept for future allocations.
+
+  Raises a RuntimeError if any object allocated from the arena has a String
+  view or MemoryView (see Memory#free!).
+ */
+static VALUE sd_arena_reset(VALUE self)
+{
+  sd_arena_t *const arena = sd_arena_get(self);
+  sd_arena_check_unpinned(arena, "reset");
+  sd_arena_invalidate(self, arena);
+  arena->current = NULL;
+  arena->offset = 0;
+  arena->used = 0;
+  return self;
+}
+
+/*
+  call-seq:
+      release! => self
+
+  Invalidates every object allocated from the arena and frees all of its
+  chunks. The arena may still be used afterward.
+
+  Raises a RuntimeError if any object allocated from the arena has a String
+  view or MemoryView (see Memory#free!).
+ */
+static VALUE sd_arena_release(VALUE self)
+{
+  sd_arena_t *const arena = sd_arena_get(self);
+  sd_arena_check_unpinned(arena, "release");
+  sd_arena_invalidate(self, arena);
+  sd_arena_free_chunks(arena);
+  return self;
+}
+
+/*
+  call-seq:
+      bytesize => Integer
+
+  Returns the number of bytes allocated from the arena since it was created or
+  last reset, not counting alignment padding.
+ */
+static VALUE sd_arena_bytesize(VALUE self)
+{
+  return SIZET2NUM(sd_arena_get(self)->used);
+}
+
+/*
+  call-seq:
+      capacity => Integer
+
+  Returns the total size in bytes of the arena's chunks.
+ */
+static VALUE sd_arena_capacity(VALUE self)
+{
+  const sd_arena_chunk_t *chunk;
+  size_t capacity = 0;
+  for (chunk = sd_arena_get(self)->chunks; chunk; chunk = chunk->next) {
+    capacity += chunk->bytesize;
+  }
+  return SIZET2NUM(capacity);
+}
+
+/*
+  call-seq:
+      chunk_size => Integer
+
+  Returns the default size in bytes of the arena's chunks.
+ */
+static VALUE sd_arena_chunk_size(VALUE self)
+{
+  return SIZET2NUM(sd_arena_get(self)->chunk_size);
+}
+
+/*
+  Pools
+ */
+
+static void sd_pool_object_dfree(void *ptr)
+{
+  sd_pool_t *const pool = (sd_pool_t *)ptr;
+  if (!pool) {
+    return;
+  } else if (pool->live == 0) {
+    sd_pool_destroy(pool);
+  } else {
+    pool->orphaned = 1;
+  }
+}
+
+static size_t sd_pool_object_dsize(const void *ptr)
+{
+  const sd_pool_t *pool = (const sd_pool_t *)ptr;
+  if (!pool) {
+    return 0;
+  }
+  return sizeof(*pool) + pool->slab_count *
+    (sizeof(sd_pool_slab_t) + pool->slot_size * pool->slots_per_slab);
+}
+
+static const rb_data_type_t sd_pool_type = {
+  "Snow::Pool",
+  { 0, sd_pool_object_dfree, sd_pool_object_dsize, },
+  0, 0,
+  RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static sd_pool_t *sd_pool_get(VALUE self)
+{
+  sd_pool_t *const pool = (sd_pool_t *)rb_check_typeddata(self, &sd_pool_type);
+  if (!pool) {
+    rb_raise(rb_eRuntimeError, "Pool is not initialized");
+  }
+  return pool;
+}
+
+static VALUE sd_pool_alloc(VALUE klass)
+{
+  return TypedData_Wrap_Struct(klass, &sd_pool_type, NULL);
+}
+
+/*
+  call-seq:
+      new(size, alignment = nil, slots_per_slab = nil) => pool
+
+  Creates a pool of slots for blocks of size bytes with the given alignment,
+  which defaults to Snow::Memory::SIZEOF_VOID_POINTER. Each slot is size bytes
+  rounded up to the alignment (and to at least the size of a pointer).
+
+  Slots are allocated in slabs of slots_per_slab slots. If slots_per_slab is
+  nil, it defaults to as many slots as fit in 16kb, or 1 for large slots.
+ */
+static VALUE sd_pool_initialize(int argc, VALUE *argv, VALUE self)
+{
+  sd_pool_t *pool;
+  VALUE sd_size, sd_alignment, sd_slots_per_slab;
+  size_t size, alignment, slot_size, slots_per_slab;
+
+  rb_scan_args(argc, argv, "12", &sd_size, &sd_alignment, &sd_slots_per_slab);
+
+  if (DATA_PTR(self)) {
+    rb_raise(rb_eRuntimeError, "Pool is already initialized");
+  }
+
+  size      = NUM2SIZET(sd_size);
+  alignment = RTEST(sd_alignment) ? NUM2SIZET(sd_alignment) : SIZEOF_VOIDP;
+
+  if (size == 0) {
+    rb_raise(rb_eArgError, "Slot size must be 1 or greater");
+  } else if (!is_power_of_two(alignment)) {
+    rb_raise(rb_eArgError, "Alignment must be a power of two -- %zu is not a"
+      " power of two", alignment);
+  }
+
+  slot_size = size < sizeof(void *) ? sizeof(void *) : size;
+  if (slot_size > SIZE_MAX - alignment) {
+    rb_raise(rb_eRangeError, "Slot size %zu is too large", size);
+  }
+  slot_size = (slot_size + (alignment - 1)) & ~(alignment - 1);
+
+  if (RTEST(sd_slots_per_slab)) {
+    slots_per_slab = NUM2SIZET(sd_slots_per_slab);
+    if (slots_per_slab == 0) {
+      rb_raise(rb_eArgError, "Slots per slab must be 1 or greater");
+    }
+  } else {
+    slots_per_slab = SD_POOL_DEFAULT_SLAB_SIZE / slot_size;
+    if (slots_per_slab == 0) {
+      slots_per_slab = 1;
+    }
+  }
+
+  if (slots_per_slab > SIZE_MAX / slot_size) {
+    rb_raise(rb_eRangeError, "Slab of %zu %zu-byte slots is too large",
+      slots_per_slab, slot_size);
+  }
+
+  pool = ZALLOC(sd_pool_t);
+  pool->size            = size;
+  pool->slot_size       = slot_size;
+  pool->alignment       = alignment;
+  pool->slots_per_slab  = slots_per_slab;
+  DATA_PTR(self) = pool;
+
+  return self;
+}
+
+/*
+  call-seq:
+      alloc(klass = Snow::Memory) => Memory
+
+  Allocates a zeroed slot from the pool and returns an object of klass, which
+  must be Memory or a subclass of it, that owns the slot. The slot is returned
+  to the pool when the object is freed, either by free! or by the GC.
+ */
+static VALUE sd_pool_alloc_m(int argc, VALUE *argv, VALUE self)
+{
+  sd_pool_t *const pool = sd_pool_get(self);
+  VALUE klass, memory;
+  sd_memory_t *block;
+
+  rb_scan_args(argc, argv, "01", &klass);
+
+  if (NIL_P(klass)) {
+    klass = rb_path2class("Snow::Memory");
+  } else if (!RB_TYPE_P(klass, T_CLASS) ||
+             rb_get_alloc_func(klass) != sd_memory_alloc) {
+    rb_raise(rb_eTypeError, "Expected Memory or a subclass of it, got %"PRIsVALUE, klass);
+  }
+
+  /* Take the slot before calling initialize so it's released if that raises */
+  memory = TypedData_Make_Struct(klass, sd_memory_t, &sd_memory_type, block);
+  block->data       = sd_pool_acquire(pool);
+  block->bytesize   = pool->size;
+  block->alignment  = pool->alignment;
+  block->pool       = pool;
+  sd_class_stats_own(klass, block);
+  rb_obj_call_init(memory, 0, 0);
+
+  return memory;
+}
+
+/*
+  call-seq:
+      stats => Hash
+
+  Returns a Hash of the pool's statistics:
+
+  [:slabs]          The number of slabs allocated.
+  [:live]           The number of slots in use.
+  [:free]           The number of slots available without allocating a slab.
+  [:slot_size]      The size in bytes of a slot.
+  [:slots_per_slab] The number of slots in a slab.
+  [:bytesize]       The total size in bytes of the pool's slabs.
+ */
+static VALUE sd_pool_stats(VALUE self)
+{
+  const sd_pool_t *pool = sd_pool_get(self);
+  VALUE stats = rb_hash_new();
+  rb_hash_aset(stats, ID2SYM(rb_intern("slabs")), SIZET2NUM(pool->slab_count));
+  rb_hash_aset(stats, ID2SYM(rb_intern("live")), SIZET2NUM(pool->live));
+  rb_hash_aset(stats, ID2SYM(rb_intern("free")), SIZET2NUM(pool->free));
+  rb_hash_aset(stats, ID2SYM(rb_intern("slot_size")), SIZET2NUM(pool->slot_size));
+  rb_hash_aset(stats, ID2SYM(rb_intern("slots_per_slab")), SIZET2NUM(pool->slots_per_slab));
+  rb_hash_aset(stats, ID2SYM(rb_intern("bytesize")),
+    SIZET2NUM(pool->slab_count * pool->slot_size * pool->slots_per_slab));
+  return stats;
+}
+
+/*
+  call-seq:
+      size => Integer
+
+  Returns the size in bytes of the blocks allocated from the pool.
+ */
+static VALUE sd_pool_size(VALUE self)
+{
+  return SIZET2NUM(sd_pool_get(self)->size);
+}
+
+/*
+  call-seq:
+      alignment => Integer
+
+  Returns the alignment of the blocks allocated from the pool.
+ */
+static VALUE sd_pool_alignment(VALUE self)
+{
+  return SIZET2NUM(sd_pool_get(self)->alignment);
+}
+
+/*
+  Reduction kernels. Contiguous float and double ranges go through the
+  sd_kernels table, which Init_snowdata_bindings fills with the best variant
+  the CPU supports. Everything else goes through the scalar, strided loops in
+  sd_reduce_range and sd_dot_range. Large ranges are split into parts that are
+  reduced in parallel and then combined in order.
+ */
+
+typedef enum e_sd_reduce_op {
+  SD_REDUCE_SUM,
+  SD_REDUCE_MIN,
+  SD_REDUCE_MAX,
+  SD_REDUCE_MEAN
+} sd_reduce_op_t;
+
+typedef struct s_sd_kernels {
+  const char  *name;
+  double      (*sum_float)(const float *values, size_t count);
+  double      (*sum_double)(const double *values, size_t count);
+  float       (*min_float)(const float *values, size_t count);
+  float       (*max_float)(const float *values, size_t count);
+  double      (*min_double)(const double *values, size_t count);
+  double      (*max_double)(const double *values, size_t count);
+  double      (*dot_float)(const float *lhs, const float *rhs, size_t count);
+  double      (*dot_double)(const double *lhs, const double *rhs, size_t count);
+} sd_kernels_t;
+
+static double sd_sum_float_scalar(const float *values, size_t count)
+{
+  double sum = 0.0;
+  size_t index;
+  for (index = 0; index < count; ++index) {
+    sum += values[index];
+  }
+  return sum;
+}
+
+static double sd_sum_double_scalar(const double *values, size_t count)
+{
+  double sum = 0.0;
+  size_t index;
+  for (index = 0; index < count; ++index) {
+    sum += values[index];
+  }
+  return sum;
+}
+
+static float sd_min_float_scalar(const float *values, size_t count)
+{
+  float result = values[0];
+  size_t index;
+  for (index = 1; index < count; ++index) {
+    if (values[index] < result) {
+      result = values[index];
+    }
+  }
+  return result;
+}
+
+static float sd_max_float_scalar(const float *values, size_t count)
+{
+  float result = values[0];
+  size_t index;
+  for (index = 1; index < count; ++index) {
+    if (values[index] > result) {
+      result = values[index];
+    }
+  }
+  return result;
+}
+
+static double sd_min_double_scalar(const double *values, size_t count)
+{
+  double result = values[0];
+  size_t index;
+  for (index = 1; index < count; ++index) {
+    if (values[index] < result) {
+      result = values[index];
+    }
+  }
+  return result;
+}
+
+static double sd_max_double_scalar(const double *values, size_t count)
+{
+  double result = values[0];
+  size_t index;
+  for (index = 1; index < count; ++index) {
+    if (values[index] > result) {
+      result = values[index];
+    }
+  }
+  return result;
+}
+
+static double sd_dot_float_scalar(const float *lhs, const float *rhs, size_t count)
+{
+  double sum = 0.0;
+  size_t index;
+  for (index = 0; index < count; ++index) {
+    sum += (double)lhs[index] * (double)rhs[index];
+  }
+  return sum;
+}
+
+static double sd_dot_double_scalar(const double *lhs, const double *rhs, size_t count)
+{
+  double sum = 0.0;
+  size_t index;
+  for (index = 0; index < count; ++index) {
+    sum += lhs[index] * rhs[index];
+  }
+  return sum;
+}
+
+static const sd_kernels_t sd_kernels_scalar = {
+  "scalar",
+  sd_sum_float_scalar,
+  sd_sum_double_scalar,
+  sd_min_float_scalar,
+  sd_max_float_scalar,
+  sd_min_double_scalar,
+  sd_max_double_scalar,
+  sd_dot_float_scalar,
+  sd_dot_double_scalar
+};
+
+#ifdef SD_X86_SIMD
+
+/*
+  SSE2 kernels. SSE2 is part of x86-64, so these are always usable when
+  SD_X86_SIMD is defined. Float sums and dot products are accumulated as
+  doubles, as in the scalar kernels.
+ */
+
+static double sd_sum_float_sse2(const float *values, size_t count)
+{
+  __m128d low = _mm_setzero_pd();
+  __m128d high = _mm_setzero_pd();
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    const __m128 chunk = _mm_loadu_ps(values + index);
+    low  = _mm_add_pd(low, _mm_cvtps_pd(chunk));
+    high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(chunk, chunk)));
+  }
+
+  _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+  return lanes[0] + lanes[1] + sd_sum_float_scalar(values + index, count - index);
+}
+
+static double sd_sum_double_sse2(const double *values, size_t count)
+{
+  __m128d low = _mm_setzero_pd();
+  __m128d high = _mm_setzero_pd();
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    low  = _mm_add_pd(low, _mm_loadu_pd(values + index));
+    high = _mm_add_pd(high, _mm_loadu_pd(values + index + 2));
+  }
+
+  _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+  return lanes[0] + lanes[1] + sd_sum_double_scalar(values + index, count - index);
+}
+
+static float sd_min_float_sse2(const float *values, size_t count)
+{
+  __m128 result = _mm_set1_ps(values[0]);
+  float lanes[4];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    result = _mm_min_ps(result, _mm_loadu_ps(values + index));
+  }
+
+  _mm_storeu_ps(lanes, result);
+  lanes[0] = sd_min_float_scalar(lanes, 4);
+  if (index < count) {
+    const float rest = sd_min_float_scalar(values + index, count - index);
+    return rest < lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+static float sd_max_float_sse2(const float *values, size_t count)
+{
+  __m128 result = _mm_set1_ps(values[0]);
+  float lanes[4];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    result = _mm_max_ps(result, _mm_loadu_ps(values + index));
+  }
 
-    if (length == ~(size_t)0
-        || (offset + length) > self_length
-        || (offset + length) < offset) {
-      length = self_length - offset;
+  _mm_storeu_ps(lanes, result);
+  lanes[0] = sd_max_float_scalar(lanes, 4);
+  if (index < count) {
+    const float rest = sd_max_float_scalar(values + index, count - index);
+    return rest > lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+static double sd_min_double_sse2(const double *values, size_t count)
+{
+  __m128d result = _mm_set1_pd(values[0]);
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 2 <= count; index += 2) {
+    result = _mm_min_pd(result, _mm_loadu_pd(values + index));
+  }
+
+  _mm_storeu_pd(lanes, result);
+  lanes[0] = sd_min_double_scalar(lanes, 2);
+  if (index < count) {
+    const double rest = sd_min_double_scalar(values + index, count - index);
+    return rest < lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+static double sd_max_double_sse2(const double *values, size_t count)
+{
+  __m128d result = _mm_set1_pd(values[0]);
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 2 <= count; index += 2) {
+    result = _mm_max_pd(result, _mm_loadu_pd(values + index));
+  }
+
+  _mm_storeu_pd(lanes, result);
+  lanes[0] = sd_max_double_scalar(lanes, 2);
+  if (index < count) {
+    const double rest = sd_max_double_scalar(values + index, count - index);
+    return rest > lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+static double sd_dot_float_sse2(const float *lhs, const float *rhs, size_t count)
+{
+  __m128d low = _mm_setzero_pd();
+  __m128d high = _mm_setzero_pd();
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    const __m128 left = _mm_loadu_ps(lhs + index);
+    const __m128 right = _mm_loadu_ps(rhs + index);
+    low  = _mm_add_pd(low, _mm_mul_pd(_mm_cvtps_pd(left), _mm_cvtps_pd(right)));
+    high = _mm_add_pd(high, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(left, left)),
+                                       _mm_cvtps_pd(_mm_movehl_ps(right, right))));
+  }
+
+  _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+  return lanes[0] + lanes[1] + sd_dot_float_scalar(lhs + index, rhs + index, count - index);
+}
+
+static double sd_dot_double_sse2(const double *lhs, const double *rhs, size_t count)
+{
+  __m128d low = _mm_setzero_pd();
+  __m128d high = _mm_setzero_pd();
+  double lanes[2];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    low  = _mm_add_pd(low, _mm_mul_pd(_mm_loadu_pd(lhs + index), _mm_loadu_pd(rhs + index)));
+    high = _mm_add_pd(high, _mm_mul_pd(_mm_loadu_pd(lhs + index + 2), _mm_loadu_pd(rhs + index + 2)));
+  }
+
+  _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+  return lanes[0] + lanes[1] + sd_dot_double_scalar(lhs + index, rhs + index, count - index);
+}
+
+static const sd_kernels_t sd_kernels_sse2 = {
+  "sse2",
+  sd_sum_float_sse2,
+  sd_sum_double_sse2,
+  sd_min_float_sse2,
+  sd_max_float_sse2,
+  sd_min_double_sse2,
+  sd_max_double_sse2,
+  sd_dot_float_sse2,
+  sd_dot_double_sse2
+};
+
+/*
+  AVX kernels. These are compiled for AVX regardless of the build's target and
+  only used if the CPU reports AVX support at load time.
+ */
+
+#define SD_TARGET_AVX __attribute__((target("avx")))
+
+SD_TARGET_AVX
+static double sd_sum_float_avx(const float *values, size_t count)
+{
+  __m256d low = _mm256_setzero_pd();
+  __m256d high = _mm256_setzero_pd();
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    low  = _mm256_add_pd(low, _mm256_cvtps_pd(_mm_loadu_ps(values + index)));
+    high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm_loadu_ps(values + index + 4)));
+  }
+
+  _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+    sd_sum_float_scalar(values + index, count - index);
+}
+
+SD_TARGET_AVX
+static double sd_sum_double_avx(const double *values, size_t count)
+{
+  __m256d low = _mm256_setzero_pd();
+  __m256d high = _mm256_setzero_pd();
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    low  = _mm256_add_pd(low, _mm256_loadu_pd(values + index));
+    high = _mm256_add_pd(high, _mm256_loadu_pd(values + index + 4));
+  }
+
+  _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+    sd_sum_double_scalar(values + index, count - index);
+}
+
+SD_TARGET_AVX
+static float sd_min_float_avx(const float *values, size_t count)
+{
+  __m256 result = _mm256_set1_ps(values[0]);
+  float lanes[8];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    result = _mm256_min_ps(result, _mm256_loadu_ps(values + index));
+  }
+
+  _mm256_storeu_ps(lanes, result);
+  lanes[0] = sd_min_float_scalar(lanes, 8);
+  if (index < count) {
+    const float rest = sd_min_float_scalar(values + index, count - index);
+    return rest < lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+SD_TARGET_AVX
+static float sd_max_float_avx(const float *values, size_t count)
+{
+  __m256 result = _mm256_set1_ps(values[0]);
+  float lanes[8];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    result = _mm256_max_ps(result, _mm256_loadu_ps(values + index));
+  }
+
+  _mm256_storeu_ps(lanes, result);
+  lanes[0] = sd_max_float_scalar(lanes, 8);
+  if (index < count) {
+    const float rest = sd_max_float_scalar(values + index, count - index);
+    return rest > lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+SD_TARGET_AVX
+static double sd_min_double_avx(const double *values, size_t count)
+{
+  __m256d result = _mm256_set1_pd(values[0]);
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    result = _mm256_min_pd(result, _mm256_loadu_pd(values + index));
+  }
+
+  _mm256_storeu_pd(lanes, result);
+  lanes[0] = sd_min_double_scalar(lanes, 4);
+  if (index < count) {
+    const double rest = sd_min_double_scalar(values + index, count - index);
+    return rest < lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+SD_TARGET_AVX
+static double sd_max_double_avx(const double *values, size_t count)
+{
+  __m256d result = _mm256_set1_pd(values[0]);
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 4 <= count; index += 4) {
+    result = _mm256_max_pd(result, _mm256_loadu_pd(values + index));
+  }
+
+  _mm256_storeu_pd(lanes, result);
+  lanes[0] = sd_max_double_scalar(lanes, 4);
+  if (index < count) {
+    const double rest = sd_max_double_scalar(values + index, count - index);
+    return rest > lanes[0] ? rest : lanes[0];
+  }
+  return lanes[0];
+}
+
+SD_TARGET_AVX
+static double sd_dot_float_avx(const float *lhs, const float *rhs, size_t count)
+{
+  __m256d low = _mm256_setzero_pd();
+  __m256d high = _mm256_setzero_pd();
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    low  = _mm256_add_pd(low, _mm256_mul_pd(
+      _mm256_cvtps_pd(_mm_loadu_ps(lhs + index)),
+      _mm256_cvtps_pd(_mm_loadu_ps(rhs + index))));
+    high = _mm256_add_pd(high, _mm256_mul_pd(
+      _mm256_cvtps_pd(_mm_loadu_ps(lhs + index + 4)),
+      _mm256_cvtps_pd(_mm_loadu_ps(rhs + index + 4))));
+  }
+
+  _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+    sd_dot_float_scalar(lhs + index, rhs + index, count - index);
+}
+
+SD_TARGET_AVX
+static double sd_dot_double_avx(const double *lhs, const double *rhs, size_t count)
+{
+  __m256d low = _mm256_setzero_pd();
+  __m256d high = _mm256_setzero_pd();
+  double lanes[4];
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    low  = _mm256_add_pd(low, _mm256_mul_pd(
+      _mm256_loadu_pd(lhs + index), _mm256_loadu_pd(rhs + index)));
+    high = _mm256_add_pd(high, _mm256_mul_pd(
+      _mm256_loadu_pd(lhs + index + 4), _mm256_loadu_pd(rhs + index + 4)));
+  }
+
+  _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+    sd_dot_double_scalar(lhs + index, rhs + index, count - index);
+}
+
+static const sd_kernels_t sd_kernels_avx = {
+  "avx",
+  sd_sum_float_avx,
+  sd_sum_double_avx,
+  sd_min_float_avx,
+  sd_max_float_avx,
+  sd_min_double_avx,
+  sd_max_double_avx,
+  sd_dot_float_avx,
+  sd_dot_double_avx
+};
+
+#endif /* SD_X86_SIMD */
+
+/* Kernels in use, selected by Init_snowdata_bindings. */
+static sd_kernels_t sd_kernels;
+
+/*
+  How a type's values are summed and compared: as 64-bit signed integers,
+  64-bit unsigned integers, or doubles.
+ */
+typedef enum e_sd_number_class {
+  SD_NUMBER_SIGNED,
+  SD_NUMBER_UNSIGNED,
+  SD_NUMBER_FLOAT
+} sd_number_class_t;
+
+/*
+  The result of reducing part of a range. Integer sums are kept in isum,
+  wrapping around at 64 bits, and floating point sums in fsum. best holds the
+  min or max so far, widened to its number class.
+ */
+typedef struct s_sd_partial {
+  uint64_t isum;
+  double   fsum;
+  union {
+    int64_t  i;
+    uint64_t u;
+    double   f;
+  } best;
+} sd_partial_t;
+
+/*
+  Arguments for SD_REDUCE_RANGE and SD_DOT_RANGE by number class: the sum
+  field, the type sums are accumulated as, the type values are widened to
+  before they're added, and the field of best to use.
+ */
+#define SD_SIGNED_RANGE   isum, uint64_t, int64_t, i
+#define SD_UNSIGNED_RANGE isum, uint64_t, uint64_t, u
+#define SD_FLOAT_RANGE    fsum, double, double, f
+
+/*
+  Reduces count values of CTYPE, stride bytes apart, into out for op. count
+  must be at least 1. Expects data, count, stride, op, out, and index in scope.
+ */
+#define SD_REDUCE_RANGE(CTYPE, CLASS) SD_REDUCE_RANGE_(CTYPE, CLASS)
+#define SD_REDUCE_RANGE_(CTYPE, SUM, ACC_TYPE, WIDE_TYPE, BEST)                 \
+  do {                                                                          \
+    if (op == SD_REDUCE_SUM || op == SD_REDUCE_MEAN) {                          \
+      ACC_TYPE sum = 0;                                                         \
+      for (index = 0; index < count; ++index, data += stride) {                 \
+        sum += (ACC_TYPE)(WIDE_TYPE)*(const CTYPE *)data;                       \
+      }                                                                         \
+      out->SUM = sum;                                                           \
+    } else {                                                                    \
+      CTYPE result = *(const CTYPE *)data;                                      \
+      for (index = 1, data += stride; index < count; ++index, data += stride) { \
+        const CTYPE value = *(const CTYPE *)data;                               \
+        if (op == SD_REDUCE_MIN ? (value < result) : (value > result)) {        \
+          result = value;                                                       \
+        }                                                                       \
+      }                                                                         \
+      out->best.BEST = (WIDE_TYPE)result;                                       \
+    }                                                                           \
+  } while (0)
+
+/*
+  Sums the products of count pairs of CTYPE values, each side stride bytes
+  apart, into out. Expects lhs, rhs, lhs_stride, rhs_stride, count, out, and
+  index in scope.
+ */
+#define SD_DOT_RANGE(CTYPE, CLASS) SD_DOT_RANGE_(CTYPE, CLASS)
+#define SD_DOT_RANGE_(CTYPE, SUM, ACC_TYPE, WIDE_TYPE, BEST)                    \
+  do {                                                                          \
+    ACC_TYPE sum = 0;                                                           \
+    for (index = 0; index < count; ++index, lhs += lhs_stride, rhs += rhs_stride) { \
+      sum += (ACC_TYPE)(WIDE_TYPE)*(const CTYPE *)lhs *                         \
+             (ACC_TYPE)(WIDE_TYPE)*(const CTYPE *)rhs;                          \
+    }                                                                           \
+    out->SUM = sum;                                                             \
+  } while (0)
+
+static sd_number_class_t sd_type_number_class(sd_type_t type)
+{
+  switch (type) {
+  case SD_TYPE_UINT8_T:
+  case SD_TYPE_UINT16_T:
+  case SD_TYPE_UINT32_T:
+  case SD_TYPE_UINT64_T:
+  case SD_TYPE_SIZE_T:
+  case SD_TYPE_UINTPTR_T:
+  case SD_TYPE_UNSIGNED_LONG:
+  case SD_TYPE_UNSIGNED_LONG_LONG:
+  case SD_TYPE_UNSIGNED_INT:
+  case SD_TYPE_UNSIGNED_SHORT:
+  case SD_TYPE_UNSIGNED_CHAR:
+    return SD_NUMBER_UNSIGNED;
+  case SD_TYPE_FLOAT:
+  case SD_TYPE_DOUBLE:
+    return SD_NUMBER_FLOAT;
+  default:
+    return SD_NUMBER_SIGNED;
+  }
+}
+
+/*
+  Reduces count values of the given type, starting at data and stride bytes
+  apart, into out. count must be at least 1 and type must not be a struct.
+ */
+static void sd_reduce_range(sd_type_t type, sd_reduce_op_t op, const uint8_t *data,
+  size_t count, size_t stride, sd_partial_t *out)
+{
+  size_t index;
+
+  if (type == SD_TYPE_FLOAT && stride == sizeof(float)) {
+    const float *values = (const float *)data;
+    switch (op) {
+    case SD_REDUCE_SUM:
+    case SD_REDUCE_MEAN: out->fsum = sd_kernels.sum_float(values, count); return;
+    case SD_REDUCE_MIN:  out->best.f = sd_kernels.min_float(values, count); return;
+    case SD_REDUCE_MAX:  out->best.f = sd_kernels.max_float(values, count); return;
+    }
+  } else if (type == SD_TYPE_DOUBLE && stride == sizeof(double)) {
+    const double *values = (const double *)data;
+    switch (op) {
+    case SD_REDUCE_SUM:
+    case SD_REDUCE_MEAN: out->fsum = sd_kernels.sum_double(values, count); return;
+    case SD_REDUCE_MIN:  out->best.f = sd_kernels.min_double(values, count); return;
+    case SD_REDUCE_MAX:  out->best.f = sd_kernels.max_double(values, count); return;
+    }
+  }
+
+  switch (type) {
+  case SD_TYPE_INT8_T:             SD_REDUCE_RANGE(int8_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT16_T:            SD_REDUCE_RANGE(int16_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT32_T:            SD_REDUCE_RANGE(int32_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT64_T:            SD_REDUCE_RANGE(int64_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UINT8_T:            SD_REDUCE_RANGE(uint8_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT16_T:           SD_REDUCE_RANGE(uint16_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT32_T:           SD_REDUCE_RANGE(uint32_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT64_T:           SD_REDUCE_RANGE(uint64_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SIZE_T:             SD_REDUCE_RANGE(size_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_PTRDIFF_T:          SD_REDUCE_RANGE(ptrdiff_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INTPTR_T:           SD_REDUCE_RANGE(intptr_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UINTPTR_T:          SD_REDUCE_RANGE(uintptr_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_LONG:               SD_REDUCE_RANGE(long, SD_SIGNED_RANGE); break;
+  case SD_TYPE_LONG_LONG:          SD_REDUCE_RANGE(long long, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_LONG:      SD_REDUCE_RANGE(unsigned long, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_LONG_LONG: SD_REDUCE_RANGE(unsigned long long, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_FLOAT:              SD_REDUCE_RANGE(float, SD_FLOAT_RANGE); break;
+  case SD_TYPE_DOUBLE:             SD_REDUCE_RANGE(double, SD_FLOAT_RANGE); break;
+  case SD_TYPE_INT:                SD_REDUCE_RANGE(int, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_INT:       SD_REDUCE_RANGE(unsigned int, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SHORT:              SD_REDUCE_RANGE(short, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_SHORT:     SD_REDUCE_RANGE(unsigned short, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_CHAR:               SD_REDUCE_RANGE(char, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_CHAR:      SD_REDUCE_RANGE(unsigned char, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SIGNED_CHAR:        SD_REDUCE_RANGE(signed char, SD_SIGNED_RANGE); break;
+  case SD_TYPE_STRUCT:             break;
+  }
+}
+
+/*
+  Sums the products of count pairs of values of the given type from lhs and
+  rhs, each side stride bytes apart, into out. type must not be a struct.
+ */
+static void sd_dot_range(sd_type_t type, const uint8_t *lhs, size_t lhs_stride,
+  const uint8_t *rhs, size_t rhs_stride, size_t count, sd_partial_t *out)
+{
+  size_t index;
+
+  if (type == SD_TYPE_FLOAT && lhs_stride == sizeof(float) && rhs_stride == sizeof(float)) {
+    out->fsum = sd_kernels.dot_float((const float *)lhs, (const float *)rhs, count);
+    return;
+  } else if (type == SD_TYPE_DOUBLE && lhs_stride == sizeof(double) && rhs_stride == sizeof(double)) {
+    out->fsum = sd_kernels.dot_double((const double *)lhs, (const double *)rhs, count);
+    return;
+  }
+
+  switch (type) {
+  case SD_TYPE_INT8_T:             SD_DOT_RANGE(int8_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT16_T:            SD_DOT_RANGE(int16_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT32_T:            SD_DOT_RANGE(int32_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INT64_T:            SD_DOT_RANGE(int64_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UINT8_T:            SD_DOT_RANGE(uint8_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT16_T:           SD_DOT_RANGE(uint16_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT32_T:           SD_DOT_RANGE(uint32_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UINT64_T:           SD_DOT_RANGE(uint64_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SIZE_T:             SD_DOT_RANGE(size_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_PTRDIFF_T:          SD_DOT_RANGE(ptrdiff_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_INTPTR_T:           SD_DOT_RANGE(intptr_t, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UINTPTR_T:          SD_DOT_RANGE(uintptr_t, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_LONG:               SD_DOT_RANGE(long, SD_SIGNED_RANGE); break;
+  case SD_TYPE_LONG_LONG:          SD_DOT_RANGE(long long, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_LONG:      SD_DOT_RANGE(unsigned long, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_LONG_LONG: SD_DOT_RANGE(unsigned long long, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_FLOAT:              SD_DOT_RANGE(float, SD_FLOAT_RANGE); break;
+  case SD_TYPE_DOUBLE:             SD_DOT_RANGE(double, SD_FLOAT_RANGE); break;
+  case SD_TYPE_INT:                SD_DOT_RANGE(int, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_INT:       SD_DOT_RANGE(unsigned int, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SHORT:              SD_DOT_RANGE(short, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_SHORT:     SD_DOT_RANGE(unsigned short, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_CHAR:               SD_DOT_RANGE(char, SD_SIGNED_RANGE); break;
+  case SD_TYPE_UNSIGNED_CHAR:      SD_DOT_RANGE(unsigned char, SD_UNSIGNED_RANGE); break;
+  case SD_TYPE_SIGNED_CHAR:        SD_DOT_RANGE(signed char, SD_SIGNED_RANGE); break;
+  case SD_TYPE_STRUCT:             break;
+  }
+}
+
+/*
+  Folds the partial result of a later part of a range, next, into result.
+ */
+static void sd_partial_combine(sd_partial_t *result, const sd_partial_t *next,
+  sd_number_class_t number_class, sd_reduce_op_t op)
+{
+  switch (op) {
+  case SD_REDUCE_SUM:
+  case SD_REDUCE_MEAN:
+    result->isum += next->isum;
+    result->fsum += next->fsum;
+    break;
+  case SD_REDUCE_MIN:
+  case SD_REDUCE_MAX:
+    switch (number_class) {
+    case SD_NUMBER_SIGNED:
+      if (op == SD_REDUCE_MIN ? (next->best.i < result->best.i) : (next->best.i > result->best.i)) {
+        result->best.i = next->best.i;
+      }
+      break;
+    case SD_NUMBER_UNSIGNED:
+      if (op == SD_REDUCE_MIN ? (next->best.u < result->best.u) : (next->best.u > result->best.u)) {
+        result->best.u = next->best.u;
+      }
+      break;
+    case SD_NUMBER_FLOAT:
+      if (op == SD_REDUCE_MIN ? (next->best.f < result->best.f) : (next->best.f > result->best.f)) {
+        result->best.f = next->best.f;
+      }
+      break;
+    }
+    break;
+  }
+}
+
+/*
+  Converts the result of reducing count values of the given type for op to a
+  Ruby object.
+ */
+static VALUE sd_partial_to_num(const sd_partial_t *result, sd_type_t type,
+  sd_reduce_op_t op, size_t count)
+{
+  const sd_number_class_t number_class = sd_type_number_class(type);
+
+  switch (op) {
+  case SD_REDUCE_SUM:
+    switch (number_class) {
+    case SD_NUMBER_SIGNED:   return LL2NUM((long long)(int64_t)result->isum);
+    case SD_NUMBER_UNSIGNED: return ULL2NUM((unsigned long long)result->isum);
+    case SD_NUMBER_FLOAT:    return DBL2NUM(result->fsum);
     }
+    break;
+  case SD_REDUCE_MEAN:
+    switch (number_class) {
+    case SD_NUMBER_SIGNED:   return DBL2NUM((double)(int64_t)result->isum / (double)count);
+    case SD_NUMBER_UNSIGNED: return DBL2NUM((double)result->isum / (double)count);
+    case SD_NUMBER_FLOAT:    return DBL2NUM(result->fsum / (double)count);
+    }
+    break;
+  case SD_REDUCE_MIN:
+  case SD_REDUCE_MAX:
+    if (type == SD_TYPE_CHAR) {
+      return SD_CHAR_TO_NUM((char)result->best.i);
+    }
+    switch (number_class) {
+    case SD_NUMBER_SIGNED:   return LL2NUM((long long)result->best.i);
+    case SD_NUMBER_UNSIGNED: return ULL2NUM((unsigned long long)result->best.u);
+    case SD_NUMBER_FLOAT:    return DBL2NUM(result->best.f);
+    }
+    break;
+  }
+
+  return Qnil;
+}
+
+/*
+  A reduction or dot product split into tasks by element range. rhs is NULL
+  unless the job is a dot product, in which case op is SD_REDUCE_SUM. Each
+  task writes its own partial result, which are combined in order afterward.
+ */
+typedef struct s_sd_reduce_job {
+  sd_type_t       type;
+  sd_reduce_op_t  op;
+  const uint8_t   *lhs;
+  size_t          lhs_stride;
+  const uint8_t   *rhs;
+  size_t          rhs_stride;
+  size_t          count;
+  size_t          tasks;
+  sd_partial_t    result;
+  sd_partial_t    partials[SD_MAX_PARALLELISM];
+} sd_reduce_job_t;
+
+static void sd_reduce_task(void *context, size_t task)
+{
+  sd_reduce_job_t *const job = (sd_reduce_job_t *)context;
+  const size_t begin = job->count / job->tasks * task;
+  const size_t end = (task + 1 == job->tasks) ? job->count : begin + job->count / job->tasks;
+  sd_partial_t *const out = &job->partials[task];
+
+  memset(out, 0, sizeof(*out));
+  if (job->rhs) {
+    sd_dot_range(job->type,
+      job->lhs + begin * job->lhs_stride, job->lhs_stride,
+      job->rhs + begin * job->rhs_stride, job->rhs_stride,
+      end - begin, out);
   } else {
-    for (length = offset; length < self_length && data[length]; ++length)
-      ;
-    length -= offset;
+    sd_reduce_range(job->type, job->op,
+      job->lhs + begin * job->lhs_stride, end - begin, job->lhs_stride, out);
   }
+}
 
-  return rb_str_new((const char *)(data + offset), length);
+static void *sd_reduce_job_nogvl(void *ptr)
+{
+  sd_reduce_job_t *const job = (sd_reduce_job_t *)ptr;
+  const sd_number_class_t number_class = sd_type_number_class(job->type);
+  size_t task;
+
+  job->tasks = sd_parallel_task_count(job->count * job->lhs_stride);
+  if (job->tasks > job->count) {
+    job->tasks = job->count;
+  }
+
+  sd_parallel_run(sd_reduce_task, job, job->tasks);
+
+  job->result = job->partials[0];
+  for (task = 1; task < job->tasks; ++task) {
+    sd_partial_combine(&job->result, &job->partials[task], number_class, job->op);
+  }
+
+  return NULL;
 }
 
-static VALUE sd_set_string_nullterm(VALUE self, VALUE sd_offset, VALUE sd_value, int null_terminated)
+/*
+  Runs a reduction job over a non-empty range and returns its result as a Ruby
+  object. lhs_block and rhs_block are the Memory blocks read, and rhs_block may
+  be NULL.
+ */
+static VALUE sd_reduce_job_run(sd_reduce_job_t *job, sd_memory_t *lhs_block, sd_memory_t *rhs_block)
 {
-  uint8_t *data              = DATA_PTR(self);
-  const uint8_t *string_data = (const uint8_t *)StringValueCStr(sd_value);
-  size_t offset              = NUM2SIZET(sd_offset);
-  /* Subtract 1 from the block length to account for a null character) */
-  size_t length              = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE)) - null_terminated;
-  size_t str_length          = RSTRING_LEN(sd_value);
+  if (job->type == SD_TYPE_STRUCT) {
+    rb_raise(rb_eTypeError, job->rhs
+      ? "Cannot compute the dot product of a struct type"
+      : "Cannot reduce values of a struct type");
+  }
 
-  if (offset >= length) {
-    return sd_value;
+  sd_call_maybe_without_gvl(sd_reduce_job_nogvl, job, job->count * job->lhs_stride,
+    lhs_block, rhs_block);
+
+  return sd_partial_to_num(&job->result, job->type, job->op, job->count);
+}
+
+/*
+  Returns the type info for a primitive type name, raising an ArgumentError if
+  there's no such primitive type.
+ */
+static const sd_type_info_t *sd_require_type_info(VALUE sd_type)
+{
+  const sd_type_info_t *info = sd_find_type_info(sd_type);
+  if (!info) {
+    rb_raise(rb_eArgError, "Unknown primitive type %"PRIsVALUE, sd_type);
   }
+  return info;
+}
 
-  length -= offset;
-  if (str_length < length) {
-    length = str_length;
+static VALUE sd_memory_reduce(int argc, VALUE *argv, VALUE self, sd_reduce_op_t op)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  const sd_type_info_t *info;
+  VALUE sd_type, sd_offset, sd_count, sd_stride;
+  size_t offset, count, stride;
+  sd_reduce_job_t job;
+
+  rb_scan_args(argc, argv, "31", &sd_type, &sd_offset, &sd_count, &sd_stride);
+
+  info    = sd_require_type_info(sd_type);
+  offset  = NUM2SIZET(sd_offset);
+  count   = NUM2SIZET(sd_count);
+  stride  = sd_get_stride(sd_stride, info->size);
+
+  sd_check_block_range(block, offset, count, stride, info->size);
+  if (count == 0) {
+    /* Sums and means of empty ranges are zero and nil, respectively, and the
+       min or max of an empty range is nil. */
+    if (op != SD_REDUCE_SUM) {
+      return Qnil;
+    }
+    return sd_type_number_class(info->type) == SD_NUMBER_FLOAT ? DBL2NUM(0.0) : INT2FIX(0);
   }
+  sd_check_null_block(block);
 
-  if (length > 0) {
-    memcpy(data + offset, string_data, length);
+  job.type        = info->type;
+  job.op          = op;
+  job.lhs         = (const uint8_t *)block->data + offset;
+  job.lhs_stride  = stride;
+  job.rhs         = NULL;
+  job.rhs_stride  = 0;
+  job.count       = count;
+
+  return sd_reduce_job_run(&job, block, NULL);
+}
+
+/*
+  call-seq:
+      reduce_sum(type, offset, count, stride = nil) => Numeric
+
+  Returns the sum of count values of the given primitive type (e.g., :float),
+  starting at offset and stride bytes apart. If stride is nil, it defaults to
+  the size of the type, in which case float and double ranges are summed using
+  SIMD instructions where available.
+
+  Float and double values are summed as doubles and returned as a Float.
+  Integer values are summed as 64-bit integers, wrapping on overflow. The sum of
+  zero values is zero. Large ranges are summed in parts when
+  Memory::parallelism is above 1, so float and double sums may differ in their
+  last bits from a sum taken with a different parallelism.
+ */
+static VALUE sd_memory_reduce_sum(int argc, VALUE *argv, VALUE self)
+{
+  return sd_memory_reduce(argc, argv, self, SD_REDUCE_SUM);
+}
+
+/*
+  call-seq:
+      reduce_min(type, offset, count, stride = nil) => Numeric or nil
+
+  Returns the smallest of count values of the given primitive type, starting at
+  offset and stride bytes apart, or nil if count is zero. How NaNs are handled
+  depends on the kernel used and is unspecified.
+ */
+static VALUE sd_memory_reduce_min(int argc, VALUE *argv, VALUE self)
+{
+  return sd_memory_reduce(argc, argv, self, SD_REDUCE_MIN);
+}
+
+/*
+  call-seq:
+      reduce_max(type, offset, count, stride = nil) => Numeric or nil
+
+  Returns the largest of count values of the given primitive type, starting at
+  offset and stride bytes apart, or nil if count is zero. How NaNs are handled
+  depends on the kernel used and is unspecified.
+ */
+static VALUE sd_memory_reduce_max(int argc, VALUE *argv, VALUE self)
+{
+  return sd_memory_reduce(argc, argv, self, SD_REDUCE_MAX);
+}
+
+/*
+  call-seq:
+      reduce_mean(type, offset, count, stride = nil) => Float or nil
+
+  Returns the arithmetic mean of count values of the given primitive type,
+  starting at offset and stride bytes apart, or nil if count is zero.
+ */
+static VALUE sd_memory_reduce_mean(int argc, VALUE *argv, VALUE self)
+{
+  return sd_memory_reduce(argc, argv, self, SD_REDUCE_MEAN);
+}
+
+/*
+  call-seq:
+      reduce_dot(type, offset, other, other_offset, count, stride = nil, other_stride = nil) => Numeric
+
+  Returns the dot product of count values of the given primitive type from the
+  receiver and count values of the same type from other, a Memory object
+  (which may be the receiver). Each side starts at its offset and steps its
+  stride, which defaults to the size of the type.
+
+  As with reduce_sum, floating point products are summed as doubles and
+  integer products as wrapping 64-bit integers.
+ */
+static VALUE sd_memory_reduce_dot(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  sd_memory_t *other;
+  const sd_type_info_t *info;
+  VALUE sd_type, sd_offset, sd_other, sd_other_offset, sd_count, sd_stride, sd_other_stride;
+  size_t offset, other_offset, count, stride, other_stride;
+  sd_reduce_job_t job;
+
+  rb_scan_args(argc, argv, "52", &sd_type, &sd_offset, &sd_other, &sd_other_offset,
+    &sd_count, &sd_stride, &sd_other_stride);
+
+  if (!rb_typeddata_is_kind_of(sd_other, &sd_memory_type)) {
+    rb_raise(rb_eTypeError, "Other must be Memory, but got %s",
+      rb_obj_classname(sd_other));
   }
 
-  if (null_terminated) {
-    data[offset + length] = '\0';
+  other         = sd_memory_get(sd_other);
+  info          = sd_require_type_info(sd_type);
+  offset        = NUM2SIZET(sd_offset);
+  other_offset  = NUM2SIZET(sd_other_offset);
+  count         = NUM2SIZET(sd_count);
+  stride        = sd_get_stride(sd_stride, info->size);
+  other_stride  = sd_get_stride(sd_other_stride, info->size);
+
+  sd_check_block_range(block, offset, count, stride, info->size);
+  sd_check_block_range(other, other_offset, count, other_stride, info->size);
+  if (count == 0) {
+    return sd_type_number_class(info->type) == SD_NUMBER_FLOAT ? DBL2NUM(0.0) : INT2FIX(0);
   }
+  sd_check_null_block(block);
+  sd_check_null_block(other);
+
+  job.type        = info->type;
+  job.op          = SD_REDUCE_SUM;
+  job.lhs         = (const uint8_t *)block->data + offset;
+  job.lhs_stride  = stride;
+  job.rhs         = (const uint8_t *)other->data + other_offset;
+  job.rhs_stride  = other_stride;
+  job.count       = count;
+
+  return sd_reduce_job_run(&job, block, other);
+}
 
-  return sd_value;
+/*
+  Record sorting. Records are stride bytes apart and sorted by one or more
+  primitive keys at fixed offsets into each record. Each key's values are
+  mapped to unsigned integers that order the same way -- signed values have
+  their sign bit flipped, and floats have every bit flipped if they're
+  negative and their sign bit flipped otherwise -- and packed big-endian into
+  one composite key per record, inverted for descending sorts.
+
+  Composite keys of up to 8 bytes are sorted with an LSD radix sort, skipping
+  bytes every key shares. When there are few enough records, each record's
+  index is packed into the low bits of its key so only one array is moved.
+  Wider composite keys are introsorted, breaking ties by index. Either way,
+  the sort is stable, and its result is the order of the records' original
+  indices, which is then either returned or applied to the records.
+ */
+
+#define SD_SORT_MAX_KEYS        16
+#define SD_SORT_INSERTION_SIZE  16
+
+typedef struct s_sd_sort_key {
+  size_t            offset;
+  size_t            type_size;
+  size_t            length;
+  sd_number_class_t number_class;
+} sd_sort_key_t;
+
+typedef struct s_sd_sort_job {
+  uint8_t       *data;
+  size_t        count;
+  size_t        stride;
+  sd_sort_key_t keys[SD_SORT_MAX_KEYS];
+  size_t        key_count;
+  size_t        key_width;      /* Bytes in a composite key */
+  int           descending;
+  int           permute;
+  unsigned      index_bits;     /* Bits packed under radix keys, or 0 */
+  /* Scratch space, allocated and freed while holding the GVL */
+  uint64_t      *radix_keys;    /* 2 * count keys, if key_width <= 8 */
+  uint8_t       *wide_keys;     /* count * key_width bytes, otherwise */
+  size_t        *order;         /* 2 * count indices if radix sorting unpacked */
+  uint8_t       *record;        /* One record, for permuting */
+} sd_sort_job_t;
+
+/*
+  Reads a value of the given size and number class and returns it mapped to an
+  unsigned integer of the same size that orders the same way.
+ */
+static uint64_t sd_sort_encode(const uint8_t *data, size_t size, sd_number_class_t number_class)
+{
+  const uint64_t mask = size >= 8 ? ~(uint64_t)0 : (((uint64_t)1 << (size * 8)) - 1);
+  const uint64_t sign = (uint64_t)1 << (size * 8 - 1);
+  uint64_t bits;
+
+  switch (size) {
+  case 1: { uint8_t  value = *data;                 bits = value; } break;
+  case 2: { uint16_t value; memcpy(&value, data, 2); bits = value; } break;
+  case 4: { uint32_t value; memcpy(&value, data, 4); bits = value; } break;
+  case 8: { uint64_t value; memcpy(&value, data, 8); bits = value; } break;
+  default: bits = 0; break;
+  }
+
+  switch (number_class) {
+  case SD_NUMBER_SIGNED:  return bits ^ sign;
+  case SD_NUMBER_FLOAT:   return (bits & sign) ? (~bits & mask) : (bits | sign);
+  default:                return bits;
+  }
+}
+
+/* Returns the composite key of a record whose key_width is at most 8. */
+static uint64_t sd_sort_radix_key(const sd_sort_job_t *job, const uint8_t *record)
+{
+  uint64_t key = 0;
+  size_t key_index, element;
+
+  for (key_index = 0; key_index < job->key_count; ++key_index) {
+    const sd_sort_key_t *const sort_key = &job->keys[key_index];
+    const uint8_t *value = record + sort_key->offset;
+    for (element = 0; element < sort_key->length; ++element, value += sort_key->type_size) {
+      const uint64_t encoded = sd_sort_encode(value, sort_key->type_size, sort_key->number_class);
+      key = sort_key->type_size >= 8 ? encoded : ((key << (sort_key->type_size * 8)) | encoded);
+    }
+  }
+
+  if (job->descending) {
+    key = job->key_width >= 8 ? ~key : (~key & (((uint64_t)1 << (job->key_width * 8)) - 1));
+  }
+
+  return key;
+}
+
+/* Writes the composite key of a record to out, big-endian. */
+static void sd_sort_wide_key(const sd_sort_job_t *job, const uint8_t *record, uint8_t *out)
+{
+  size_t key_index, element;
+  uint8_t *const start = out;
+  size_t byte;
+
+  for (key_index = 0; key_index < job->key_count; ++key_index) {
+    const sd_sort_key_t *const sort_key = &job->keys[key_index];
+    const uint8_t *value = record + sort_key->offset;
+    for (element = 0; element < sort_key->length; ++element, value += sort_key->type_size) {
+      const uint64_t encoded = sd_sort_encode(value, sort_key->type_size, sort_key->number_class);
+      for (byte = sort_key->type_size; byte > 0; --byte) {
+        *out++ = (uint8_t)(encoded >> ((byte - 1) * 8));
+      }
+    }
+  }
+
+  if (job->descending) {
+    for (byte = 0; byte < job->key_width; ++byte) {
+      start[byte] = (uint8_t)~start[byte];
+    }
+  }
 }
 
-/*
-  call-seq:
-      set_string(offset, value, null_terminated = false) -> value
+/*
+  Sorts count keys by bytes first_byte through last_byte - 1 (counting from the
+  least significant), moving order along with them if it's not NULL. keys_tmp
+  and order_tmp must each have room for count entries. The sorted keys and
+  order end up in keys and order.
+ */
+static void sd_radix_sort(uint64_t *keys, uint64_t *keys_tmp, size_t *order, size_t *order_tmp,
+  size_t count, unsigned first_byte, unsigned last_byte)
+{
+  size_t counts[8][256];
+  uint64_t *source_keys = keys, *dest_keys = keys_tmp;
+  size_t *source_order = order, *dest_order = order_tmp;
+  size_t index;
+  unsigned byte;
+
+  memset(counts, 0, sizeof(counts));
+  for (index = 0; index < count; ++index) {
+    const uint64_t key = keys[index];
+    for (byte = first_byte; byte < last_byte; ++byte) {
+      counts[byte][(key >> (byte * 8)) & 0xFF] += 1;
+    }
+  }
+
+  for (byte = first_byte; byte < last_byte; ++byte) {
+    size_t *const bucket = counts[byte];
+    const unsigned shift = byte * 8;
+    size_t total = 0;
+    unsigned digit;
+
+    /* Every key has the same digit here, so the pass wouldn't move anything */
+    if (bucket[(source_keys[0] >> shift) & 0xFF] == count) {
+      continue;
+    }
+
+    for (digit = 0; digit < 256; ++digit) {
+      const size_t digit_count = bucket[digit];
+      bucket[digit] = total;
+      total += digit_count;
+    }
+
+    if (source_order) {
+      for (index = 0; index < count; ++index) {
+        const size_t position = bucket[(source_keys[index] >> shift) & 0xFF]++;
+        dest_keys[position] = source_keys[index];
+        dest_order[position] = source_order[index];
+      }
+    } else {
+      for (index = 0; index < count; ++index) {
+        dest_keys[bucket[(source_keys[index] >> shift) & 0xFF]++] = source_keys[index];
+      }
+    }
 
-  Copies the string value into the block at the offset supplied.
+    {
+      uint64_t *const swap_keys = source_keys;
+      size_t *const swap_order = source_order;
+      source_keys   = dest_keys;
+      dest_keys     = swap_keys;
+      source_order  = dest_order;
+      dest_order    = swap_order;
+    }
+  }
 
-  If null_terminated is true, it will always write a null-terminating character
-  if it fits. This means that you need at least string.bytesize + 1 bytes
-  available from the offset onwards to fully story a string, otherwise the
-  string's contents will be truncated to fit the null-terminating character.
+  if (source_keys != keys) {
+    memcpy(keys, source_keys, count * sizeof(*keys));
+    if (order) {
+      memcpy(order, source_order, count * sizeof(*order));
+    }
+  }
+}
 
-  If null_terminated is false, no null character is written and only the string
-  bytes are copied to the block. If the full string does not fit, it will be
-  truncated.
- */
-static VALUE sd_set_string(int argc, VALUE *argv, VALUE self)
+/* Whether the record at index lhs sorts before the one at rhs by wide keys. */
+static int sd_sort_wide_less(const sd_sort_job_t *job, size_t lhs, size_t rhs)
 {
-  VALUE sd_offset, sd_value, sd_null_terminated;
-
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  const int result = memcmp(job->wide_keys + lhs * job->key_width,
+    job->wide_keys + rhs * job->key_width, job->key_width);
+  return result < 0 || (result == 0 && lhs < rhs);
+}
 
-  rb_scan_args(argc, argv, "21", &sd_offset, &sd_value, &sd_null_terminated);
+static void sd_sort_wide_sift(const sd_sort_job_t *job, size_t *order, size_t root, size_t count)
+{
+  const size_t value = order[root];
+  size_t child;
 
-  return sd_set_string_nullterm(self, sd_offset, sd_value, !!RTEST(sd_null_terminated));
+  while ((child = root * 2 + 1) < count) {
+    if (child + 1 < count && sd_sort_wide_less(job, order[child], order[child + 1])) {
+      child += 1;
+    }
+    if (!sd_sort_wide_less(job, value, order[child])) {
+      break;
+    }
+    order[root] = order[child];
+    root = child;
+  }
+  order[root] = value;
 }
 
 /*
-  Frees memory associated with self regardless of whether the object is frozen.
+  Sorts count record indices by their wide keys: quicksort with a
+  median-of-three pivot, falling back to heapsort past depth_limit levels and
+  finishing short runs with insertion sort.
  */
-static void sd_memory_force_free(VALUE self)
+static void sd_sort_wide(const sd_sort_job_t *job, size_t *order, size_t count, size_t depth_limit)
 {
-  struct RData *data = RDATA(self);
+  size_t index;
+
+  while (count > SD_SORT_INSERTION_SIZE) {
+    size_t lower, upper, middle, pivot;
+
+    if (depth_limit-- == 0) {
+      for (index = count / 2; index > 0; --index) {
+        sd_sort_wide_sift(job, order, index - 1, count);
+      }
+      for (index = count - 1; index > 0; --index) {
+        const size_t top = order[0];
+        order[0] = order[index];
+        order[index] = top;
+        sd_sort_wide_sift(job, order, 0, index);
+      }
+      return;
+    }
 
-  if (data->data && data->dfree) {
-    data->dfree(data->data);
-    data->dfree = 0;
-  } else if (!data->data) {
-    rb_raise(rb_eRuntimeError,
-      "Double-free on %s",
-      rb_obj_classname(self));
+    /* Order the first, middle, and last indices, then partition around the
+       middle one */
+    middle = count / 2;
+    upper = count - 1;
+#define SD_SORT_SWAP(A, B) do { const size_t swap_ = order[A]; order[A] = order[B]; order[B] = swap_; } while (0)
+    if (sd_sort_wide_less(job, order[middle], order[0])) { SD_SORT_SWAP(middle, 0); }
+    if (sd_sort_wide_less(job, order[upper], order[middle])) {
+      SD_SORT_SWAP(upper, middle);
+      if (sd_sort_wide_less(job, order[middle], order[0])) { SD_SORT_SWAP(middle, 0); }
+    }
+    pivot = order[middle];
+
+    lower = 0;
+    for (;;) {
+      while (sd_sort_wide_less(job, order[lower], pivot)) { ++lower; }
+      while (sd_sort_wide_less(job, pivot, order[upper])) { --upper; }
+      if (lower >= upper) {
+        break;
+      }
+      SD_SORT_SWAP(lower, upper);
+      ++lower;
+      --upper;
+    }
+#undef SD_SORT_SWAP
+
+    /* Recurse into the smaller side and loop on the larger one */
+    if (upper + 1 < count - upper - 1) {
+      sd_sort_wide(job, order, upper + 1, depth_limit);
+      order += upper + 1;
+      count -= upper + 1;
+    } else {
+      sd_sort_wide(job, order + upper + 1, count - upper - 1, depth_limit);
+      count = upper + 1;
+    }
   }
 
-  data->data = 0;
-  rb_ivar_set(self, kSD_IVAR_BYTESIZE, INT2FIX(0));
+  for (index = 1; index < count; ++index) {
+    const size_t value = order[index];
+    size_t position = index;
+    while (position > 0 && sd_sort_wide_less(job, value, order[position - 1])) {
+      order[position] = order[position - 1];
+      --position;
+    }
+    order[position] = value;
+  }
 }
 
 /*
-  Returns a Data object wrapped with the given klass and the appropriate size
-  and alignment instance variables.
+  Moves the records so that the record at index i is the one that was at
+  order[i]. Records are gathered into a scratch block and copied back, which
+  reads them in sorted order but writes them sequentially. If a scratch block
+  can't be allocated, the permutation is instead applied in place by following
+  its cycles, which only needs room for one record but writes them in no
+  particular order. Either way, order may be overwritten.
  */
-static VALUE sd_wrap_memory(VALUE klass, void *data, size_t size, size_t alignment, sd_free_memory_flag_t should_free)
+static void sd_sort_permute(sd_sort_job_t *job, size_t *order)
 {
-  VALUE memory = Data_Wrap_Struct(klass, 0, (should_free ? com_free : 0), data);
-  rb_ivar_set(memory, kSD_IVAR_BYTESIZE, SIZET2NUM(size));
-  rb_ivar_set(memory, kSD_IVAR_ALIGNMENT, SIZET2NUM(alignment));
-  rb_obj_call_init(memory, 0, 0);
-  return memory;
-}
+  uint8_t *const data = job->data;
+  const size_t stride = job->stride;
+  uint8_t *scratch;
+  size_t start;
 
-/*
-  call-seq:
-      new(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
-      wrap(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
-      __wrap__(address, size, alignment = SIZEOF_VOID_POINTER) => Memory
+  for (start = 0; start < job->count && order[start] == start; ++start) {
+    /* Skip the records that are already in place */
+  }
+  if (start == job->count) {
+    return;
+  }
 
-  Creates a new Memory object that wraps an existing pointer. Alignment is
-  optional and defaults to the size of a pointer (Memory::SIZEOF_VOID_POINTER).
+  /* Allocated with malloc rather than xmalloc, since this runs without the
+     GVL, and a failure here isn't fatal */
+  scratch = (uint8_t *)malloc((job->count - start) * stride);
+  if (scratch) {
+    uint8_t *dest = scratch;
+    size_t index;
+    for (index = start; index < job->count; ++index, dest += stride) {
+      memcpy(dest, data + order[index] * stride, stride);
+    }
+    memcpy(data + start * stride, scratch, (job->count - start) * stride);
+    free(scratch);
+    return;
+  }
 
-  Size must be greater than zero. Zero-sized blocks are not permitted as they
-  render most memory functionality useless and make it very difficult to ensure
-  nothing bad is happening when you do bad things with snow-data. Because, let's
-  be honest with ourselves for a moment, everyone using this gem? They're bad
-  people. They're very bad people.
+  for (; start < job->count; ++start) {
+    size_t hole = start;
 
-  Note that Memory objects created with this method will not attempt to free
-  the memory they wrap, as they did not allocate it and so do not own it. If
-  an address held by a Memory object is invalid, the Memory object is also
-  implicitly invalid as well, though there is no way for it to check this. You
-  are responsible for freeing any memory not allocated through ::malloc and
-  Memory subclasses.
+    if (order[start] == start) {
+      continue;
+    }
 
-  It is an ArgumentError to provide a size of zero, nil, or false. It is also
-  an ArgumentError to provide a NULL (zero) address.
+    memcpy(job->record, data + start * stride, stride);
+    for (;;) {
+      const size_t next = order[hole];
+      order[hole] = hole;
+      if (next == start) {
+        memcpy(data + hole * stride, job->record, stride);
+        break;
+      }
+      memcpy(data + hole * stride, data + next * stride, stride);
+      hole = next;
+    }
+  }
+}
 
-  If a subclass overrides ::new, it is also aliased as ::wrap and ::__wrap__.
-  Subclasses may override ::wrap or ::new but must never override ::__wrap__.
- */
-static VALUE sd_memory_new(int argc, VALUE *argv, VALUE self)
+static void *sd_sort_nogvl(void *arg)
 {
-  VALUE sd_size;
-  VALUE sd_address;
-  VALUE sd_alignment;
-  VALUE memory = Qnil;
-  void *address;
-  size_t size;
-  size_t alignment;
+  sd_sort_job_t *const job = (sd_sort_job_t *)arg;
+  const size_t count = job->count;
+  const uint8_t *record = job->data;
+  size_t index;
+
+  if (job->radix_keys) {
+    uint64_t *const keys = job->radix_keys;
+    const unsigned key_bits = (unsigned)job->key_width * 8;
+
+    if (job->index_bits) {
+      for (index = 0; index < count; ++index, record += job->stride) {
+        keys[index] = (sd_sort_radix_key(job, record) << job->index_bits) | index;
+      }
+      /* The low bytes hold nothing but indices, which are already in order */
+      sd_radix_sort(keys, keys + count, NULL, NULL, count,
+        job->index_bits / 8, (key_bits + job->index_bits + 7) / 8);
+      for (index = 0; index < count; ++index) {
+        job->order[index] = (size_t)(keys[index] & (((uint64_t)1 << job->index_bits) - 1));
+      }
+    } else {
+      for (index = 0; index < count; ++index, record += job->stride) {
+        keys[index] = sd_sort_radix_key(job, record);
+        job->order[index] = index;
+      }
+      sd_radix_sort(keys, keys + count, job->order, job->order + count, count,
+        0, key_bits / 8);
+    }
+  } else {
+    size_t depth_limit = 0;
+    for (index = count; index > 1; index >>= 1) {
+      depth_limit += 2;
+    }
+    for (index = 0; index < count; ++index, record += job->stride) {
+      sd_sort_wide_key(job, record, job->wide_keys + index * job->key_width);
+      job->order[index] = index;
+    }
+    sd_sort_wide(job, job->order, count, depth_limit);
+  }
 
-  rb_scan_args(argc, argv, "21", &sd_address, &sd_size, &sd_alignment);
+  if (job->permute) {
+    sd_sort_permute(job, job->order);
+  }
 
-  address = (void *)SD_NUM_TO_INTPTR_T(sd_address);
-  size = 0;
-  alignment = SIZEOF_VOIDP;
+  return NULL;
+}
 
-  if (address == NULL) {
-    rb_raise(rb_eArgError, "Address is NULL (%p).", address);
-  }
+typedef struct s_sd_sort_call {
+  sd_sort_job_t *job;
+  sd_memory_t   *block;
+} sd_sort_call_t;
 
-  if (RTEST(sd_size)) {
-    size = NUM2SIZET(sd_size);
+static VALUE sd_sort_call(VALUE arg)
+{
+  sd_sort_call_t *const call = (sd_sort_call_t *)arg;
+  sd_sort_job_t *const job = call->job;
+  VALUE sd_order;
+  size_t index;
+
+  if (job->key_width <= 8) {
+    job->radix_keys = ALLOC_N(uint64_t, job->count * 2);
+    job->order = ALLOC_N(size_t, job->index_bits ? job->count : job->count * 2);
   } else {
-    rb_raise(rb_eArgError, "Block size is false or nil");
+    job->wide_keys = ALLOC_N(uint8_t, job->count * job->key_width);
+    job->order = ALLOC_N(size_t, job->count);
   }
-
-  if (!size) {
-    rb_raise(rb_eArgError, "Block size must be 1 or greater");
+  if (job->permute) {
+    job->record = ALLOC_N(uint8_t, job->stride);
   }
 
-  if (RTEST(sd_alignment)) {
-    alignment = NUM2SIZET(sd_alignment);
+  sd_call_maybe_without_gvl(sd_sort_nogvl, job, job->count * job->stride, call->block, NULL);
+
+  if (job->permute) {
+    return Qnil;
   }
 
-  memory = sd_wrap_memory(self, address, size, alignment, SD_DO_NOT_FREE_MEMORY);
+  sd_order = rb_ary_new_capa((long)job->count);
+  for (index = 0; index < job->count; ++index) {
+    rb_ary_push(sd_order, SIZET2NUM(job->order[index]));
+  }
+  return sd_order;
+}
 
-  return memory;
+static VALUE sd_sort_free(VALUE arg)
+{
+  sd_sort_job_t *const job = ((sd_sort_call_t *)arg)->job;
+  xfree(job->radix_keys);
+  xfree(job->wide_keys);
+  xfree(job->order);
+  xfree(job->record);
+  return Qnil;
 }
 
 /*
   call-seq:
-      malloc(size, alignment = nil) => Memory
-      __malloc__(size, alignment = nil) => Memory
+      __sort_records__(keys, count, stride, descending, permute) => Array or self
+
+  Sorts count records, stride bytes apart from the start of the block, by the
+  given keys. Each key is an Array of [type, offset, length]: a primitive type
+  and the offset of the first of length values of it in each record, compared
+  in order. Records are compared by their first key, then their second, and so
+  on, and records with equal keys keep their relative order.
+
+  If permute is true, the records are moved into sorted order and self is
+  returned. Otherwise, the records are left as they are and an Array of their
+  indices in sorted order is returned. This is called by
+  CStruct::StructArrayBase#sort_by_member! and #argsort and shouldn't be called
+  otherwise.
+ */
+static VALUE sd_memory_sort_records(VALUE self, VALUE sd_keys, VALUE sd_count, VALUE sd_stride,
+  VALUE sd_descending, VALUE sd_permute)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  sd_sort_job_t job;
+  sd_sort_call_t call;
+  size_t key_index;
+  VALUE sd_result;
+
+  Check_Type(sd_keys, T_ARRAY);
+  memset(&job, 0, sizeof(job));
+  job.count       = NUM2SIZET(sd_count);
+  job.stride      = NUM2SIZET(sd_stride);
+  job.descending  = RTEST(sd_descending);
+  job.permute     = RTEST(sd_permute);
+  job.key_count   = (size_t)RARRAY_LEN(sd_keys);
+
+  if (job.stride == 0) {
+    rb_raise(rb_eArgError, "Stride must be 1 or greater");
+  } else if (job.key_count == 0) {
+    rb_raise(rb_eArgError, "No keys to sort by");
+  } else if (job.key_count > SD_SORT_MAX_KEYS) {
+    rb_raise(rb_eArgError, "Cannot sort by more than %d keys", SD_SORT_MAX_KEYS);
+  } else if (job.permute) {
+    sd_check_writable(self, block);
+  }
 
-  Allocates a new block with the given size and alignment and returns it. If
-  no alignment is specified, it defaults to Snow::Memory::SIZEOF_VOID_POINTER.
+  for (key_index = 0; key_index < job.key_count; ++key_index) {
+    sd_sort_key_t *const sort_key = &job.keys[key_index];
+    const VALUE sd_key = rb_check_array_type(RARRAY_AREF(sd_keys, (long)key_index));
+    const sd_type_info_t *info;
 
-  Raises a RangeError if either size is zero or alignment is not a power of two.
+    if (NIL_P(sd_key) || RARRAY_LEN(sd_key) != 3) {
+      rb_raise(rb_eArgError, "Sort keys must be [type, offset, length] Arrays");
+    }
 
-  If a subclass overrides ::malloc, which is a bad idea and should not be done,
-  then it is aliased as ::__malloc__ as well. Subclasses must never override
-  ::__malloc__.
- */
-static VALUE sd_memory_malloc(int argc, VALUE *argv, VALUE self)
-{
-  VALUE sd_size;
-  VALUE sd_alignment;
-  size_t alignment;
-  size_t size;
-  void *data;
-  VALUE memory;
+    info                    = sd_require_type_info(RARRAY_AREF(sd_key, 0));
+    sort_key->offset        = NUM2SIZET(RARRAY_AREF(sd_key, 1));
+    sort_key->length        = NUM2SIZET(RARRAY_AREF(sd_key, 2));
+    sort_key->type_size     = info->size;
+    sort_key->number_class  = sd_type_number_class(info->type);
+
+    if (sort_key->length == 0) {
+      rb_raise(rb_eArgError, "Sort key length must be 1 or greater");
+    } else if (sort_key->offset > job.stride ||
+               sort_key->length > (job.stride - sort_key->offset) / sort_key->type_size) {
+      rb_raise(rb_eRangeError, "Sort key at offset %zu is out of bounds for a %zu-byte record",
+        sort_key->offset, job.stride);
+    }
+    job.key_width += sort_key->type_size * sort_key->length;
+  }
 
-  rb_scan_args(argc, argv, "11", &sd_size, &sd_alignment);
+  sd_check_block_range(block, 0, job.count, job.stride, job.stride);
+  if (job.count < 2) {
+    if (job.permute) {
+      return self;
+    }
+    return job.count ? rb_ary_new_from_args(1, INT2FIX(0)) : rb_ary_new();
+  }
+  sd_check_null_block(block);
+  job.data = (uint8_t *)block->data;
 
-  /* Get size and alignment */
-  size = NUM2SIZET(sd_size);
-  alignment = RTEST(sd_alignment) ? NUM2SIZET(sd_alignment) : sizeof(void *);
-  if (!is_power_of_two(alignment)) {
-    rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not a"
-      " power of two", alignment);
-  } else if (size < 1) {
-    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
-      " blocks are not permitted");
+  if (job.key_width <= 8) {
+    unsigned index_bits = 0;
+    while (index_bits < 64 && ((job.count - 1) >> index_bits) != 0) {
+      ++index_bits;
+    }
+    /* Pack indices into the keys if both fit in 64 bits */
+    if (job.key_width * 8 + index_bits <= 64) {
+      job.index_bits = index_bits;
+    }
   }
 
-  /* Allocate block */
-  data = com_malloc(size, alignment);
-  memory = sd_wrap_memory(self, data, size, alignment, SD_FREE_MEMORY);
+  call.job    = &job;
+  call.block  = block;
+  sd_result = rb_ensure(sd_sort_call, (VALUE)&call, sd_sort_free, (VALUE)&call);
 
-  return memory;
+  return job.permute ? self : sd_result;
 }
 
-#ifdef SD_ALLOW_ALLOCA
 /*
-  call-seq:
-      alloca(size) { |memory| ... } => result of block
-      __alloca__(size) { |memory| ... } => result of block
+  Content hashing and checksums. content_hash is XXH64, which only needs
+  64-bit multiplies, so it gives the same result on every machine. crc32c uses
+  the SSE4.2 crc32 instruction if the CPU has it (or the ARMv8 CRC32
+  instructions if the build targets them) and slicing-by-8 tables otherwise.
+  Large CRCs are split across the parallel pool and the parts' CRCs combined.
+ */
 
-  Allocates size bytes on the stack and yields it to a block before for use,
-  then returns the result of the block. Outside of the block, any use of the
-  yielded memory's address is considered undefined behavior and may lead to
-  crashes or worse. The yielded memory is only valid for the duration of the
-  block. If you want to preserve the memory after use, either duplicate the
-  memory block or realloc! the memory, both of which will copy it from the stack
-  to the heap.
+#define SD_XXH_PRIME64_1  0x9E3779B185EBCA87ULL
+#define SD_XXH_PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define SD_XXH_PRIME64_3  0x165667B19E3779F9ULL
+#define SD_XXH_PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define SD_XXH_PRIME64_5  0x27D4EB2F165667C5ULL
 
-  The alignment of the yielded memory is always the size of a pointer.
+/* Reflected CRC-32C (Castagnoli) polynomial */
+#define SD_CRC32C_POLY    0x82F63B78U
 
-  Because of how downright evil alloca is in some situations, it is disabled by
-  default. You must explicitly install snow-data with the --allow-alloca flag to
-  use this function. If you're not certain whether alloca is available for a
-  particular installation, then you should check if the Memory class responds to
-  it first.
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
-      if Snow::Memory.respond_to?(:__alloca__)
-        Snow::Memory.__alloca__(64) { |mem|
-          # ...
-        }
-      end
+static uint32_t sd_crc32c_table[8][256];
+/* x^(2^n) mod P for n = 0..31, used to combine CRCs */
+static uint32_t sd_crc32c_x2n_table[32];
 
-  Subclasses may override alloca to provide a predefined size argument, but
-  subclasses must never override __alloca__. It is considered bad form to
-  implement __alloca__ using heap allocation for installations that don't
-  provide it.
- */
-static VALUE sd_memory_alloca(VALUE self, VALUE sd_size)
+static uint64_t sd_read_u64_le(const uint8_t *bytes)
 {
-  VALUE result = Qnil;
-  void *stack_memory = NULL;
-  struct RData *block_data;
-  size_t size = NUM2SIZET(sd_size);
-  VALUE block;
+  return (uint64_t)bytes[0]         | ((uint64_t)bytes[1] << 8)  |
+         ((uint64_t)bytes[2] << 16) | ((uint64_t)bytes[3] << 24) |
+         ((uint64_t)bytes[4] << 32) | ((uint64_t)bytes[5] << 40) |
+         ((uint64_t)bytes[6] << 48) | ((uint64_t)bytes[7] << 56);
+}
 
-  rb_need_block();
+static uint32_t sd_read_u32_le(const uint8_t *bytes)
+{
+  return (uint32_t)bytes[0]         | ((uint32_t)bytes[1] << 8) |
+         ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
 
-  if (size == 0) {
-    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
-      " blocks are not permitted.");
+static uint64_t sd_rotl64(uint64_t value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t sd_xxh64_round(uint64_t acc, uint64_t input)
+{
+  acc += input * SD_XXH_PRIME64_2;
+  acc = sd_rotl64(acc, 31);
+  return acc * SD_XXH_PRIME64_1;
+}
+
+static uint64_t sd_xxh64_merge_round(uint64_t acc, uint64_t value)
+{
+  acc ^= sd_xxh64_round(0, value);
+  return acc * SD_XXH_PRIME64_1 + SD_XXH_PRIME64_4;
+}
+
+static uint64_t sd_xxh64(const uint8_t *data, size_t length, uint64_t seed)
+{
+  const uint8_t *const end = data + length;
+  uint64_t hash;
+
+  if (length >= 32) {
+    const uint8_t *const limit = end - 32;
+    uint64_t v1 = seed + SD_XXH_PRIME64_1 + SD_XXH_PRIME64_2;
+    uint64_t v2 = seed + SD_XXH_PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - SD_XXH_PRIME64_1;
+
+    do {
+      v1 = sd_xxh64_round(v1, sd_read_u64_le(data));
+      v2 = sd_xxh64_round(v2, sd_read_u64_le(data + 8));
+      v3 = sd_xxh64_round(v3, sd_read_u64_le(data + 16));
+      v4 = sd_xxh64_round(v4, sd_read_u64_le(data + 24));
+      data += 32;
+    } while (data <= limit);
+
+    hash = sd_rotl64(v1, 1) + sd_rotl64(v2, 7) + sd_rotl64(v3, 12) + sd_rotl64(v4, 18);
+    hash = sd_xxh64_merge_round(hash, v1);
+    hash = sd_xxh64_merge_round(hash, v2);
+    hash = sd_xxh64_merge_round(hash, v3);
+    hash = sd_xxh64_merge_round(hash, v4);
+  } else {
+    hash = seed + SD_XXH_PRIME64_5;
   }
 
-  stack_memory = alloca(size);
-  if (stack_memory == NULL) {
-    rb_raise(rb_eNoMemError,
-      "Failed to allocated %zu bytes via alloca",
-      size);
+  hash += (uint64_t)length;
+
+  for (; data + 8 <= end; data += 8) {
+    hash ^= sd_xxh64_round(0, sd_read_u64_le(data));
+    hash = sd_rotl64(hash, 27) * SD_XXH_PRIME64_1 + SD_XXH_PRIME64_4;
   }
 
-  block = sd_wrap_memory(self, stack_memory, size, SIZEOF_VOIDP, SD_DO_NOT_FREE_MEMORY);
-  block_data = RDATA(block);
-  result = rb_yield(block);
+  if (data + 4 <= end) {
+    hash ^= (uint64_t)sd_read_u32_le(data) * SD_XXH_PRIME64_1;
+    hash = sd_rotl64(hash, 23) * SD_XXH_PRIME64_2 + SD_XXH_PRIME64_3;
+    data += 4;
+  }
 
-  /*
-    If the block hasn't been realloc!'d or freed, free it now if it hasn't been
-    frozen for some reason.
-   */
-  if (block_data->data == stack_memory && !block_data->dfree && !OBJ_FROZEN(block)) {
-    sd_memory_force_free(block);
+  for (; data < end; ++data) {
+    hash ^= (uint64_t)*data * SD_XXH_PRIME64_5;
+    hash = sd_rotl64(hash, 11) * SD_XXH_PRIME64_1;
   }
 
-  return result;
+  hash ^= hash >> 33;
+  hash *= SD_XXH_PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= SD_XXH_PRIME64_3;
+  hash ^= hash >> 32;
+
+  return hash;
 }
-#endif
 
 /*
-  call-seq:
-      realloc!(size, alignment = nil) => self
+  CRC-32C update functions. These take and return the CRC register, i.e. the
+  CRC before its final inversion.
+ */
 
-  Reallocates the memory backing this pointer with a new size and optionally a
-  new alignment. If the new size is the same as the old size, the method returns
-  early and nothing is reallocated.
+static uint32_t sd_crc32c_update_table(uint32_t crc, const uint8_t *data, size_t length)
+{
+  for (; length >= 8; data += 8, length -= 8) {
+    const uint64_t word = sd_read_u64_le(data) ^ crc;
+    crc = sd_crc32c_table[7][word & 0xFF] ^
+          sd_crc32c_table[6][(word >> 8) & 0xFF] ^
+          sd_crc32c_table[5][(word >> 16) & 0xFF] ^
+          sd_crc32c_table[4][(word >> 24) & 0xFF] ^
+          sd_crc32c_table[3][(word >> 32) & 0xFF] ^
+          sd_crc32c_table[2][(word >> 40) & 0xFF] ^
+          sd_crc32c_table[1][(word >> 48) & 0xFF] ^
+          sd_crc32c_table[0][word >> 56];
+  }
 
-  If a new alignment is specified, the memory will be reallocated regardless of
-  whether the new and old sizes are the same. If no alignment is specified, the
-  memory's previous alignment is used.
+  for (; length > 0; ++data, --length) {
+    crc = sd_crc32c_table[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+  }
 
-  If the block for this memory was previously freed or the block is not owner by
-  this object, a new block is allocated and the memory takes ownership of it.
-  It is fine to realloc! on a previously freed block.
+  return crc;
+}
 
-  Raises a RangeError if either size is zero or alignment is not a power of two.
- */
-static VALUE sd_memory_realloc(int argc, VALUE *argv, VALUE self)
+#if defined(SD_X86_SIMD)
+#define SD_TARGET_SSE42 __attribute__((target("sse4.2")))
+
+SD_TARGET_SSE42
+static uint32_t sd_crc32c_update_sse42(uint32_t crc, const uint8_t *data, size_t length)
 {
-  struct RData *data;
-  void *new_data;
-  size_t size;
-  size_t prev_size;
-  size_t prev_align;
-  size_t alignment;
-  VALUE sd_size;
-  VALUE sd_alignment;
+  uint64_t crc64;
 
-  /*
-    Don't check for null/zero length here, as it is safe to reuse a memory via
-    realloc!. It's less safe for structs and arrays, but you just have to do the
-    sane thing in most cases. Granted, I'm a hypocrite for saying you need to
-    do the sane thing after writing this gem.
-   */
-  rb_check_frozen(self);
+  for (; length > 0 && ((uintptr_t)data & 7); ++data, --length) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
+
+  crc64 = crc;
+  for (; length >= 8; data += 8, length -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = (uint32_t)crc64;
 
-  rb_scan_args(argc, argv, "11", &sd_size, &sd_alignment);
+  for (; length > 0; ++data, --length) {
+    crc = _mm_crc32_u8(crc, *data);
+  }
 
-  size       = NUM2SIZET(sd_size);
-  prev_align =
-  alignment  = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_ALIGNMENT));
-  prev_size  = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE));
+  return crc;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+static uint32_t sd_crc32c_update_arm(uint32_t crc, const uint8_t *data, size_t length)
+{
+  for (; length > 0 && ((uintptr_t)data & 7); ++data, --length) {
+    crc = __crc32cb(crc, *data);
+  }
 
-  if (RTEST(sd_alignment)) {
-    alignment = NUM2SIZET(sd_alignment);
+  for (; length >= 8; data += 8, length -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc = __crc32cd(crc, word);
   }
 
-  if (prev_size == size && alignment == prev_align) {
-    return self;
-  } else if (!is_power_of_two(alignment)) {
-    rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not a"
-      " power of two", alignment);
-  } else if (size < 1) {
-    rb_raise(rb_eRangeError, "Size of block must be 1 or more -- zero-byte"
-      " blocks are not permitted");
+  for (; length > 0; ++data, --length) {
+    crc = __crc32cb(crc, *data);
   }
 
-  data      = RDATA(self);
-  new_data  = com_malloc(size, alignment);
+  return crc;
+}
+#endif
+
+/* CRC-32C update function in use, selected by Init_snowdata_bindings. */
+static uint32_t (*sd_crc32c_update)(uint32_t crc, const uint8_t *data, size_t length) =
+  sd_crc32c_update_table;
+
+static void sd_crc32c_init_tables(void)
+{
+  uint32_t index, bit, table;
 
-  if (data->data && prev_size > 0) {
-    const size_t copy_sizes[2] = { prev_size, size };
-    memcpy(new_data, data->data, copy_sizes[prev_size > size]);
+  for (index = 0; index < 256; ++index) {
+    uint32_t crc = index;
+    for (bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) ? (crc >> 1) ^ SD_CRC32C_POLY : crc >> 1;
+    }
+    sd_crc32c_table[0][index] = crc;
   }
 
-  if (data->dfree) {
-    data->dfree(data->data);
-  } else if (data->data) {
-    rb_warning("realloc called on unowned pointer %p -- allocating new block"
-      " and memcpying contents (size: %zd bytes), but original block will"
-      " not be freed.", data->data, prev_size);
+  for (table = 1; table < 8; ++table) {
+    for (index = 0; index < 256; ++index) {
+      const uint32_t previous = sd_crc32c_table[table - 1][index];
+      sd_crc32c_table[table][index] = (previous >> 8) ^ sd_crc32c_table[0][previous & 0xFF];
+    }
   }
+}
 
-  data->data  = new_data;
-  data->dfree = com_free;
+/* Multiplies two polynomials modulo the CRC-32C polynomial */
+static uint32_t sd_crc32c_multmodp(uint32_t lhs, uint32_t rhs)
+{
+  uint32_t mask = 1U << 31;
+  uint32_t product = 0;
+
+  for (;;) {
+    if (lhs & mask) {
+      product ^= rhs;
+      if ((lhs & (mask - 1)) == 0) {
+        break;
+      }
+    }
+    mask >>= 1;
+    rhs = (rhs & 1) ? (rhs >> 1) ^ SD_CRC32C_POLY : rhs >> 1;
+  }
 
-  rb_ivar_set(self, kSD_IVAR_BYTESIZE,  SIZET2NUM(size));
-  rb_ivar_set(self, kSD_IVAR_ALIGNMENT, SIZET2NUM(alignment));
-  return self;
+  return product;
 }
 
-/*
-  call-seq:
-      free!() => self
-
-  Frees any memory owned by the object. This is a convenience function for when
-  you want to free the memory ahead of the object being collected by the GC.
- */
-static VALUE sd_memory_free(VALUE self)
+static void sd_crc32c_init_x2n_table(void)
 {
-  rb_check_frozen(self);
-  sd_memory_force_free(self);
-  return self;
+  uint32_t power = 1U << 30; /* x^1 */
+  size_t index;
+
+  sd_crc32c_x2n_table[0] = power;
+  for (index = 1; index < 32; ++index) {
+    sd_crc32c_x2n_table[index] = power = sd_crc32c_multmodp(power, power);
+  }
 }
 
 /*
-  call-seq:
-      copy!(source, destination_offset = nil, source_offset = nil, byte_size = nil) => self
-
-  Copies byte_size bytes from an offset in the source data to an offset into
-  the receiver (the destination).
+  Returns the CRC of two ranges concatenated, given the first's CRC, the
+  second's CRC (computed from an initial CRC of zero), and the second's length.
+ */
+static uint32_t sd_crc32c_combine(uint32_t crc, uint32_t next_crc, size_t next_length)
+{
+  uint32_t power = 1U << 31; /* x^0 */
+  size_t index = 3;          /* x^(8 * next_length), so start at x^(2^3) */
 
-  If either offset is nil, they default to zero.
+  for (; next_length; next_length >>= 1, ++index) {
+    if (next_length & 1) {
+      power = sd_crc32c_multmodp(sd_crc32c_x2n_table[index & 31], power);
+    }
+  }
 
-  If the byte_size is nil, it defaults to the receiver's #bytesize.
+  return sd_crc32c_multmodp(power, crc) ^ next_crc;
+}
 
-  If the source responds to #bytesize and the source's bytesize is smaller than
-  the size given, the source's size is used instead of the specified or default
-  size.
+typedef struct s_sd_checksum_job {
+  const uint8_t *data;
+  size_t        size;
+  uint64_t      seed;   /* Seed for content_hash, or the initial CRC for crc32c */
+  uint64_t      result;
+  size_t        tasks;
+  uint32_t      crcs[SD_MAX_PARALLELISM];
+} sd_checksum_job_t;
 
-  The source pointer does not have its bounds checked, as this isn't possible
-  for all cases. Instead, you must ensure that your source offset and byte size
-  are both within range of the source data.
+static void *sd_xxh64_nogvl(void *ptr)
+{
+  sd_checksum_job_t *const job = (sd_checksum_job_t *)ptr;
+  job->result = sd_xxh64(job->data, job->size, job->seed);
+  return NULL;
+}
 
-  For those curious, under the hood, this uses memmove, not memcpy. So, it is
-  possible to copy overlapping regions of memory, but it isn't guaranteed to be
-  as fast as a simple memcpy. Either way, if this is a concern for you, you
-  probably shouldn't be using Ruby.
+static void sd_crc32c_task(void *context, size_t task)
+{
+  sd_checksum_job_t *const job = (sd_checksum_job_t *)context;
+  const size_t begin = job->size / job->tasks * task;
+  const size_t end = (task + 1 == job->tasks) ? job->size : begin + job->size / job->tasks;
+  /* Only the first part continues the given CRC; the rest are combined in */
+  const uint32_t initial = task == 0 ? (uint32_t)job->seed : 0;
 
-  === Exceptions
+  job->crcs[task] = ~sd_crc32c_update(~initial, job->data + begin, end - begin);
+}
 
-  - If attempting to copy into a region that is outside the bounds of the
-    receiver will raise a RangeError.
-  - If either the receiver or the source address is NULL, it will raise an
-    ArgumentError.
-  - If the source object is neither a Data object (or a subclass thereof) or a
-    Numerical address, it raises a TypeError.
- */
-static VALUE sd_memory_copy(int argc, VALUE *argv, VALUE self)
+static void *sd_crc32c_nogvl(void *ptr)
 {
-  VALUE sd_source;
-  VALUE sd_destination_offset;
-  VALUE sd_source_offset;
-  VALUE sd_byte_size;
-  struct RData *self_data;
-  const uint8_t *source_pointer;
-  uint8_t *destination_pointer;
-  size_t source_offset;
-  size_t destination_offset;
-  size_t byte_size;
-  size_t self_byte_size;
-  int source_is_data = 0;
+  sd_checksum_job_t *const job = (sd_checksum_job_t *)ptr;
+  size_t part_size;
+  uint32_t crc;
+  size_t task;
+
+  job->tasks = sd_parallel_task_count(job->size);
+  part_size = job->size / job->tasks;
+  sd_parallel_run(sd_crc32c_task, job, job->tasks);
+
+  crc = job->crcs[0];
+  for (task = 1; task < job->tasks; ++task) {
+    const size_t length = (task + 1 == job->tasks) ? job->size - part_size * task : part_size;
+    crc = sd_crc32c_combine(crc, job->crcs[task], length);
+  }
+  job->result = crc;
 
-  sd_check_null_block(self);
-  rb_check_frozen(self);
+  return NULL;
+}
 
-  rb_scan_args(argc, argv, "13",
-    &sd_source,
-    &sd_destination_offset,
-    &sd_source_offset,
-    &sd_byte_size);
+/*
+  Reads an offset and length for a range of the block to hash, defaulting to
+  the whole block, and checks them against its bounds. Returns a pointer to the
+  start of the range.
+ */
+static const uint8_t *sd_get_content_range(sd_memory_t *block, VALUE sd_offset,
+  VALUE sd_length, size_t *length)
+{
+  const size_t offset = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
 
-  /*
-    By default, try to get an address from the object, if possible. Then use
-    that address and don't extract it from the Data object or what have you.
-   */
-  if (rb_obj_respond_to(sd_source, kSD_ID_ADDRESS, 0)) {
-    VALUE source_address = rb_funcall2(sd_source, kSD_ID_ADDRESS, 0, 0);
-    if (RTEST(rb_obj_is_kind_of(source_address, rb_cNumeric))) {
-      source_pointer = (uint8_t *)SD_NUM_TO_INTPTR_T(source_address);
-      goto sd_memory_copy_skip_data_check;
-    }
+  if (offset > block->bytesize) {
+    rb_raise(rb_eRangeError, "Offset %zu is out of bounds (bytesize: %zu)",
+      offset, block->bytesize);
   }
 
-  if (RTEST(rb_obj_is_kind_of(sd_source, rb_cData))) {
-    /* Otherwise extract a pointer from the object if it's a Data object */
-    const struct RData *source_data = RDATA(sd_source);
-    source_pointer = ((const uint8_t *)source_data->data);
-    source_is_data = 1;
-  } else if (RTEST(rb_obj_is_kind_of(sd_source, rb_cNumeric))) {
-    /* Otherwise, if it's a Numeric, try to convert what is assumed to be an
-      address to a pointer */
-    source_pointer = (uint8_t *)SD_NUM_TO_INTPTR_T(sd_source);
-  } else {
-    rb_raise(rb_eTypeError,
-      "Source object must be type of numeric (address) or Data- got %s",
-      rb_obj_classname(sd_source));
+  *length = RTEST(sd_length) ? NUM2SIZET(sd_length) : block->bytesize - offset;
+  if (*length > 0) {
+    sd_check_block_bounds(block, offset, *length);
+    sd_check_null_block(block);
   }
 
-sd_memory_copy_skip_data_check: /* skip from address check */
-  self_data = RDATA(self);
+  return (const uint8_t *)block->data + offset;
+}
 
-  /*
-    Check if the source pointer is NULL -- error if it is (the destination
-    pointer is checked by sd_check_null_block above).
-   */
-  if (source_pointer == NULL) {
-    rb_raise(rb_eArgError, "Source pointer is NULL");
-  }
+/*
+  call-seq:
+      eql_content?(other, offset = 0, other_offset = 0, length = nil) => true or false
 
-  /* Grab data from ruby values and offset the source pointer. */
-  source_offset       = RTEST(sd_source_offset) ? NUM2SIZET(sd_source_offset) : 0;
-  destination_offset  = RTEST(sd_destination_offset) ? NUM2SIZET(sd_destination_offset) : 0;
-  destination_pointer = (uint8_t *)self_data->data + destination_offset;
-  self_byte_size      = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE));
-  source_pointer      += source_offset;
+  Returns whether length bytes of the block starting at offset are the same as
+  length bytes of other, another Memory object, starting at other_offset. If
+  length is nil, the rest of both blocks past their offsets are compared, and
+  ranges of different lengths are never equal. Returns false if other isn't a
+  Memory object.
 
-  if (self_byte_size == 0) {
-    /*
-      If self is a zero-length block, do not try to copy. It's just not sane to
-      attempt it here since we can't do any bounds checking, even if the bounds
-      might be arbitrarily specified (in which case I'd just be shooting myself
-      in the foot if I did that and trying to circumvent the anti-foot-shot
-      protections).
-     */
-    rb_raise(rb_eRuntimeError, "self.bytesize == 0 -- cannot safely copy to this block");
-  } else if (!RTEST(sd_byte_size)) {
-    /*
-      If not copy size is specified, use self_byte_size and just try to cram as
-      much in there as is feasible. Truncate self_byte_size as needed for the
-      offset.
-     */
-    byte_size = self_byte_size - destination_offset;
-    #ifdef SD_WARN_ON_IMPLICIT_COPY_SIZE
-    if (!source_is_data) {
-      rb_warning(
-        "Copying %zu bytes from non-Data memory address %p without explicit size",
-        byte_size,
-        source_pointer);
-    }
-    #endif
-  } else {
-    /* User-specified size */
-    byte_size = NUM2SIZET(sd_byte_size);
+  Unlike #==, which only checks whether two objects refer to the same block,
+  this compares the blocks' contents, as memcmp does. Large comparisons
+  release the GVL (see ::nogvl_threshold).
+
+  Raises a RangeError if either range is outside its block.
+ */
+static VALUE sd_memory_eql_content(int argc, VALUE *argv, VALUE self)
+{
+  sd_memory_t *const block = sd_memory_get(self);
+  sd_memory_t *other;
+  VALUE sd_other, sd_offset, sd_other_offset, sd_length;
+  size_t offset, other_offset;
+  sd_bulk_op_t op;
+
+  rb_scan_args(argc, argv, "13", &sd_other, &sd_offset, &sd_other_offset, &sd_length);
+
+  if (!rb_typeddata_is_kind_of(sd_other, &sd_memory_type)) {
+    return Qfalse;
   }
 
-  /*
-    If the source responds to bytesize, check if the copy is within bounds for
-    the source. If it's out of bounds, raise a RangeError, otherwise optionally
-    emit a warning that bounds checking doesn't work for this source.
-   */
-  if (rb_obj_respond_to(sd_source, kSD_ID_BYTESIZE, 0)) {
-    size_t source_size = NUM2SIZET(rb_funcall2(sd_source, kSD_ID_BYTESIZE, 0, 0));
-    if (source_offset > source_size
-        || (source_offset + byte_size) > source_size
-        || (source_offset + byte_size) < source_offset) {
-      rb_raise(rb_eRangeError, "Attempt to copy out of source bounds");
-    }
+  other         = sd_memory_get(sd_other);
+  offset        = RTEST(sd_offset) ? NUM2SIZET(sd_offset) : 0;
+  other_offset  = RTEST(sd_other_offset) ? NUM2SIZET(sd_other_offset) : 0;
+
+  if (offset > block->bytesize || other_offset > other->bytesize) {
+    rb_raise(rb_eRangeError, "Offset is out of bounds");
   }
-  #ifdef SD_WARN_ON_NO_BYTESIZE_METHOD
-  else if (source_is_data) {
-    rb_warning(
-      "Copying from Data object pointer %p that does not respond to #bytesize"
-      " -- this operation is not bounds-checked.",
-      source_pointer);
+
+  if (RTEST(sd_length)) {
+    op.size = NUM2SIZET(sd_length);
+  } else if (block->bytesize - offset != other->bytesize - other_offset) {
+    return Qfalse;
+  } else {
+    op.size = block->bytesize - offset;
   }
-  #endif
 
-  if ((destination_offset + byte_size) > self_byte_size
-      || (destination_offset + byte_size) < destination_offset) {
-    rb_raise(rb_eRangeError,
-      "Offset %zu with byte size %zu is out of bounds of self",
-      destination_offset,
-      byte_size);
+  if (op.size == 0) {
+    return Qtrue;
   }
 
-  #ifdef SD_VERBOSE_COPY_LOG
-  /*
-    Emit some debugging info just in case things go completely haywire and you
-    really need to know what's going on.
-   */
-  fprintf(stderr,
-    "# copy! ----------------------------------------\n"
-    "#  destination_pointer = %p"             "\n"
-    "#  source_pointer      = %p"             "\n"
-    "#  destination_offset  = %zu"            "\n"
-    "#  source_offset       = %zu"            "\n"
-    "#  byte_size           = %zu"            "\n"
-    "#  self_byte_size      = %zu"            "\n"
-    "#  source.class        = %s"             "\n"
-    "#  self.class          = %s"             "\n"
-    "# --------------------------------------- /copy!\n",
-    destination_pointer - destination_offset,
-    source_pointer - source_offset,
-    destination_offset,
-    source_offset,
-    byte_size,
-    self_byte_size,
-    rb_obj_classname(sd_source),
-    rb_obj_classname(self));
-  #endif
+  sd_check_block_bounds(block, offset, op.size);
+  sd_check_block_bounds(other, other_offset, op.size);
+  sd_check_null_block(block);
+  sd_check_null_block(other);
 
-  /* And skip a copy if we can */
-  if (byte_size == 0 || source_pointer == destination_pointer) {
-    return self;
+  op.kind         = SD_BULK_COMPARE;
+  op.destination  = (uint8_t *)block->data + offset;
+  op.source       = (const uint8_t *)other->data + other_offset;
+  op.value        = 0;
+
+  if (op.destination == op.source) {
+    return Qtrue;
   }
 
-  memmove(destination_pointer, source_pointer, byte_size);
+  sd_bulk_op_run(&op, block, other);
 
-  return self;
+  RB_GC_GUARD(sd_other);
+  return op.value == 0 ? Qtrue : Qfalse;
 }
 
 /*
   call-seq:
-      to_s(null_terminated = true) => String
+      content_hash(offset = 0, length = nil, seed = 0) => Integer
 
-  Gets a string representation of the contents of this block. If null_terminated
-  is true (or nil), the returned string will end before the first null
-  character.
+  Returns a 64-bit hash of length bytes of the block starting at offset. If
+  length is nil, the rest of the block is hashed. The hash is XXH64 with the
+  given seed, so it matches other XXH64 implementations and is stable across
+  machines and processes (unlike #hash). Blocks with the same contents have
+  the same hash, so it can be used as a Hash key for deduplicating structs:
+
+      seen = {}
+      records.each { |record| seen[record.content_hash] ||= record }
+
+  Large ranges release the GVL (see ::nogvl_threshold).
+
+  Raises a RangeError if the range is outside the block.
  */
-static VALUE sd_memory_to_s(int argc, VALUE *argv, VALUE self)
+static VALUE sd_memory_content_hash(int argc, VALUE *argv, VALUE self)
 {
-  VALUE null_terminated;
-  size_t byte_size = NUM2SIZET(rb_ivar_get(self, kSD_IVAR_BYTESIZE));
-  const char *data = DATA_PTR(self);
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_length, sd_seed;
+  sd_checksum_job_t job;
 
-  sd_check_null_block(self);
-
-  rb_scan_args(argc, argv, "01", &null_terminated);
+  rb_scan_args(argc, argv, "03", &sd_offset, &sd_length, &sd_seed);
 
-  if (null_terminated == Qnil || RTEST(null_terminated)) {
-    size_t string_length = 0;
-    for (; string_length < byte_size && data[string_length]; ++string_length)
-      ;
-    byte_size = string_length;
-  }
+  job.data = sd_get_content_range(block, sd_offset, sd_length, &job.size);
+  job.seed = RTEST(sd_seed) ? NUM2ULL(sd_seed) : 0;
+  sd_call_maybe_without_gvl(sd_xxh64_nogvl, &job, job.size, block, NULL);
 
-  return rb_str_new(data, byte_size);
+  return ULL2NUM(job.result);
 }
 
 /*
   call-seq:
-      address => Integer
+      crc32c(offset = 0, length = nil, crc = 0) => Integer
 
-  Gets the address of this memory block as an Integer.
+  Returns the CRC-32C (Castagnoli) checksum of length bytes of the block
+  starting at offset. If length is nil, the rest of the block is checksummed.
+  Passing the CRC of preceding data as crc continues it, so checksumming a
+  range in pieces gives the same result as checksumming it all at once.
+
+  This uses the CPU's CRC32 instructions where available (see ::crc32c_kernel).
+  Large ranges release the GVL and are split across ::parallelism threads.
+
+  Raises a RangeError if the range is outside the block.
  */
-static VALUE sd_memory_address(VALUE self)
+static VALUE sd_memory_crc32c(int argc, VALUE *argv, VALUE self)
 {
-  return SD_UINTPTR_T_TO_NUM((uintptr_t)RDATA(self)->data);
+  sd_memory_t *const block = sd_memory_get(self);
+  VALUE sd_offset, sd_length, sd_crc;
+  sd_checksum_job_t job;
+
+  rb_scan_args(argc, argv, "03", &sd_offset, &sd_length, &sd_crc);
+
+  job.data = sd_get_content_range(block, sd_offset, sd_length, &job.size);
+  job.seed = RTEST(sd_crc) ? (NUM2ULL(sd_crc) & 0xFFFFFFFFULL) : 0;
+  sd_call_maybe_without_gvl(sd_crc32c_nogvl, &job, job.size, block, NULL);
+
+  return UINT2NUM((unsigned int)job.result);
 }
 
 /*
   call-seq:
-      align_size(size_or_offset, alignment = nil) => Integer
+      crc32c_kernel => String
 
-  Aligns a given size or offset to a specific alignment. If no alignment is
-  provided, it defaults to the size of a pointer on the architecture the
-  extension was compiled for.
+  Returns the name of the implementation used by #crc32c: "sse4.2", "arm",
+  or "table". This is picked when the extension is loaded, based on what the
+  CPU supports.
+ */
+static VALUE sd_memory_crc32c_kernel(VALUE self)
+{
+  #if defined(SD_X86_SIMD)
+  if (sd_crc32c_update == sd_crc32c_update_sse42) {
+    return rb_str_new_cstr("sse4.2");
+  }
+  #elif defined(__ARM_FEATURE_CRC32)
+  if (sd_crc32c_update == sd_crc32c_update_arm) {
+    return rb_str_new_cstr("arm");
+  }
+  #endif
+  return rb_str_new_cstr("table");
+}
 
-  See Snow::Memory::SIZEOF_VOID_POINTER for the size of a pointer.
+/*
+  call-seq:
+      simd_kernels => String
 
-  Raises a RangeError if the alignment is not a power of two. In this case, 1
-  is considered a valid power of two.
+  Returns the name of the set of kernels used by the reduce_ methods for
+  contiguous float and double ranges: "avx", "sse2", or "scalar". This is
+  picked when the extension is loaded, based on what the CPU supports.
  */
-static VALUE sd_align_size(int argc, VALUE *argv, VALUE self)
+static VALUE sd_memory_simd_kernels(VALUE self)
 {
-  VALUE sd_alignment;
-  VALUE sd_size;
-  size_t alignment = sizeof(void *);
-  rb_scan_args(argc, argv, "11", &sd_size, &sd_alignment);
-  if (RTEST(sd_alignment)) {
-    alignment = NUM2SIZET(sd_alignment);
-    if (!is_power_of_two(alignment)) {
-      rb_raise(rb_eRangeError, "Alignment must be a power of two -- %zu is not"
-        " a power of two", alignment);
-    }
-  }
-  return SIZET2NUM(align_size(NUM2SIZET(sd_size), alignment));
+  return rb_str_new_cstr(sd_kernels.name);
 }
 
 void Init_snowdata_bindings(void)
 {
   VALUE sd_snow_module  = rb_define_module("Snow");
-  VALUE sd_memory_klass = rb_define_class_under(sd_snow_module, "Memory", rb_cData);
+  VALUE sd_memory_klass = rb_define_class_under(sd_snow_module, "Memory", rb_cObject);
+  VALUE sd_arena_klass;
+  VALUE sd_pool_klass;
 
-  kSD_IVAR_BYTESIZE     = rb_intern("@__bytesize__");
-  kSD_IVAR_ALIGNMENT    = rb_intern("@__alignment__");
   kSD_ID_BYTESIZE       = rb_intern("bytesize");
   kSD_ID_ADDRESS        = rb_intern("address");
+  kSD_ID_LAYOUT         = rb_intern("__layout__");
+  kSD_IVAR_BASE_MEMORY  = rb_intern("@__base_memory__");
+  kSD_IVAR_VIEW_ROOT    = rb_intern("@__view_root__");
+  kSD_ID_TRACK_VIEW     = rb_intern("__track_view__");
 
   rb_const_set(sd_memory_klass, rb_intern("SIZEOF_INT"), SIZET2NUM(SIZEOF_INT));
   rb_const_set(sd_memory_klass, rb_intern("SIZEOF_SHORT"), SIZET2NUM(SIZEOF_SHORT));
@@ -1919,17 +9226,75 @@ void Init_snowdata_bindings(void)
   rb_const_set(sd_memory_klass, rb_intern("SIZEOF_UINTPTR_T"), SIZET2NUM(SIZEOF_UINTPTR_T));
   rb_const_set(sd_memory_klass, rb_intern("SIZEOF_VOID_POINTER"), SIZET2NUM(sizeof(void *)));
 
+  sd_kernels = sd_kernels_scalar;
+  #ifdef SD_X86_SIMD
+  __builtin_cpu_init();
+  sd_kernels = __builtin_cpu_supports("avx") ? sd_kernels_avx : sd_kernels_sse2;
+  #endif
+
+  sd_crc32c_init_tables();
+  sd_crc32c_init_x2n_table();
+  #if defined(SD_X86_SIMD)
+  if (__builtin_cpu_supports("sse4.2")) {
+    sd_crc32c_update = sd_crc32c_update_sse42;
+  }
+  #elif defined(__ARM_FEATURE_CRC32)
+  sd_crc32c_update = sd_crc32c_update_arm;
+  #endif
+
+  #ifdef SD_HAS_PTHREAD
+  pthread_atfork(NULL, NULL, sd_workers_after_fork);
+  #endif
+
+  sd_class_stats_table = st_init_numtable();
+
+  rb_define_alloc_func(sd_memory_klass, sd_memory_alloc);
   rb_define_singleton_method(sd_memory_klass, "__wrap__", sd_memory_new, -1);
   rb_define_singleton_method(sd_memory_klass, "__malloc__", sd_memory_malloc, -1);
   #ifdef SD_ALLOW_ALLOCA
   rb_define_singleton_method(sd_memory_klass, "__alloca__", sd_memory_alloca, 1);
   #endif
+  #ifdef SD_HAS_MMAP
+  rb_define_singleton_method(sd_memory_klass, "__map__", sd_memory_map, 4);
+  rb_define_method(sd_memory_klass, "msync!", sd_memory_msync, -1);
+  rb_define_method(sd_memory_klass, "advise", sd_memory_advise, -1);
+  rb_define_method(sd_memory_klass, "unmap!", sd_memory_unmap, 0);
+  #endif
+  #ifdef SD_HAS_FD_IO
+  rb_define_method(sd_memory_klass, "read_from", sd_memory_read_from, -1);
+  rb_define_method(sd_memory_klass, "write_to", sd_memory_write_to, -1);
+  #if defined(HAVE_PREAD) && defined(HAVE_PWRITE)
+  rb_define_method(sd_memory_klass, "pread", sd_memory_pread, -1);
+  rb_define_method(sd_memory_klass, "pwrite", sd_memory_pwrite, -1);
+  #endif
+  #endif
   rb_define_singleton_method(sd_memory_klass, "align_size", sd_align_size, -1);
+  rb_define_singleton_method(sd_memory_klass, "simd_kernels", sd_memory_simd_kernels, 0);
+  rb_define_singleton_method(sd_memory_klass, "crc32c_kernel", sd_memory_crc32c_kernel, 0);
+  rb_define_singleton_method(sd_memory_klass, "nogvl_threshold", sd_memory_get_nogvl_threshold, 0);
+  rb_define_singleton_method(sd_memory_klass, "nogvl_threshold=", sd_memory_set_nogvl_threshold, 1);
+  rb_define_singleton_method(sd_memory_klass, "parallelism", sd_memory_get_parallelism, 0);
+  rb_define_singleton_method(sd_memory_klass, "parallelism=", sd_memory_set_parallelism, 1);
+  rb_define_singleton_method(sd_memory_klass, "stats", sd_memory_stats, 0);
+  rb_define_singleton_method(sd_memory_klass, "class_stats", sd_memory_class_stats, 0);
+  rb_define_singleton_method(sd_memory_klass, "reset_stats!", sd_memory_reset_stats, 0);
+  rb_define_singleton_method(sd_memory_klass, "track_class_stats", sd_memory_get_track_class_stats, 0);
+  rb_define_singleton_method(sd_memory_klass, "track_class_stats=", sd_memory_set_track_class_stats, 1);
+  rb_define_private_method(rb_singleton_class(sd_memory_klass), "__define_member__", sd_struct_define_member, -1);
   rb_define_method(sd_memory_klass, "realloc!", sd_memory_realloc, -1);
   rb_define_method(sd_memory_klass, "copy!", sd_memory_copy, -1);
+  rb_define_method(sd_memory_klass, "fill!", sd_memory_fill, -1);
+  rb_define_method(sd_memory_klass, "compare", sd_memory_compare, -1);
+  rb_define_method(sd_memory_klass, "copy_strided!", sd_memory_copy_strided, 7);
   rb_define_method(sd_memory_klass, "to_s", sd_memory_to_s, -1);
   rb_define_method(sd_memory_klass, "free!", sd_memory_free, 0);
+  rb_define_private_method(sd_memory_klass, "__each_view__", sd_memory_each_view, 3);
+  rb_define_private_method(sd_memory_klass, "__rebase_views__", sd_memory_rebase_views, 3);
   rb_define_method(sd_memory_klass, "address", sd_memory_address, 0);
+  rb_define_method(sd_memory_klass, "bytesize", sd_memory_bytesize, 0);
+  rb_define_method(sd_memory_klass, "alignment", sd_memory_alignment, 0);
+  rb_define_method(sd_memory_klass, "readonly?", sd_memory_readonly, 0);
+  rb_define_private_method(sd_memory_klass, "__readonly_view_of__", sd_memory_readonly_view_of, 1);
   rb_define_method(sd_memory_klass, "get_int8_t", sd_get_int8, 1);
   rb_define_method(sd_memory_klass, "set_int8_t", sd_set_int8, 2);
   rb_define_method(sd_memory_klass, "get_int16_t", sd_get_int16, 1);
@@ -1980,6 +9345,92 @@ void Init_snowdata_bindings(void)
   rb_define_method(sd_memory_klass, "set_unsigned_char", sd_set_unsigned_char, 2);
   rb_define_method(sd_memory_klass, "get_signed_char", sd_get_signed_char, 1);
   rb_define_method(sd_memory_klass, "set_signed_char", sd_set_signed_char, 2);
+  rb_define_method(sd_memory_klass, "get_int8_t_array", sd_get_int8_array, -1);
+  rb_define_method(sd_memory_klass, "set_int8_t_array", sd_set_int8_array, -1);
+  rb_define_method(sd_memory_klass, "get_int16_t_array", sd_get_int16_array, -1);
+  rb_define_method(sd_memory_klass, "set_int16_t_array", sd_set_int16_array, -1);
+  rb_define_method(sd_memory_klass, "get_int32_t_array", sd_get_int32_array, -1);
+  rb_define_method(sd_memory_klass, "set_int32_t_array", sd_set_int32_array, -1);
+  rb_define_method(sd_memory_klass, "get_int64_t_array", sd_get_int64_array, -1);
+  rb_define_method(sd_memory_klass, "set_int64_t_array", sd_set_int64_array, -1);
+  rb_define_method(sd_memory_klass, "get_uint8_t_array", sd_get_uint8_array, -1);
+  rb_define_method(sd_memory_klass, "set_uint8_t_array", sd_set_uint8_array, -1);
+  rb_define_method(sd_memory_klass, "get_uint16_t_array", sd_get_uint16_array, -1);
+  rb_define_method(sd_memory_klass, "set_uint16_t_array", sd_set_uint16_array, -1);
+  rb_define_method(sd_memory_klass, "get_uint32_t_array", sd_get_uint32_array, -1);
+  rb_define_method(sd_memory_klass, "set_uint32_t_array", sd_set_uint32_array, -1);
+  rb_define_method(sd_memory_klass, "get_uint64_t_array", sd_get_uint64_array, -1);
+  rb_define_method(sd_memory_klass, "set_uint64_t_array", sd_set_uint64_array, -1);
+  rb_define_method(sd_memory_klass, "get_size_t_array", sd_get_size_t_array, -1);
+  rb_define_method(sd_memory_klass, "set_size_t_array", sd_set_size_t_array, -1);
+  rb_define_method(sd_memory_klass, "get_ptrdiff_t_array", sd_get_ptrdiff_t_array, -1);
+  rb_define_method(sd_memory_klass, "set_ptrdiff_t_array", sd_set_ptrdiff_t_array, -1);
+  rb_define_method(sd_memory_klass, "get_intptr_t_array", sd_get_intptr_t_array, -1);
+  rb_define_method(sd_memory_klass, "set_intptr_t_array", sd_set_intptr_t_array, -1);
+  rb_define_method(sd_memory_klass, "get_uintptr_t_array", sd_get_uintptr_t_array, -1);
+  rb_define_method(sd_memory_klass, "set_uintptr_t_array", sd_set_uintptr_t_array, -1);
+  rb_define_method(sd_memory_klass, "get_long_array", sd_get_long_array, -1);
+  rb_define_method(sd_memory_klass, "set_long_array", sd_set_long_array, -1);
+  rb_define_method(sd_memory_klass, "get_long_long_array", sd_get_long_long_array, -1);
+  rb_define_method(sd_memory_klass, "set_long_long_array", sd_set_long_long_array, -1);
+  rb_define_method(sd_memory_klass, "get_unsigned_long_array", sd_get_unsigned_long_array, -1);
+  rb_define_method(sd_memory_klass, "set_unsigned_long_array", sd_set_unsigned_long_array, -1);
+  rb_define_method(sd_memory_klass, "get_unsigned_long_long_array", sd_get_unsigned_long_long_array, -1);
+  rb_define_method(sd_memory_klass, "set_unsigned_long_long_array", sd_set_unsigned_long_long_array, -1);
+  rb_define_method(sd_memory_klass, "get_float_array", sd_get_float_array, -1);
+  rb_define_method(sd_memory_klass, "set_float_array", sd_set_float_array, -1);
+  rb_define_method(sd_memory_klass, "get_double_array", sd_get_double_array, -1);
+  rb_define_method(sd_memory_klass, "set_double_array", sd_set_double_array, -1);
+  rb_define_method(sd_memory_klass, "get_int_array", sd_get_int_array, -1);
+  rb_define_method(sd_memory_klass, "set_int_array", sd_set_int_array, -1);
+  rb_define_method(sd_memory_klass, "get_unsigned_int_array", sd_get_unsigned_int_array, -1);
+  rb_define_method(sd_memory_klass, "set_unsigned_int_array", sd_set_unsigned_int_array, -1);
+  rb_define_method(sd_memory_klass, "get_short_array", sd_get_short_array, -1);
+  rb_define_method(sd_memory_klass, "set_short_array", sd_set_short_array, -1);
+  rb_define_method(sd_memory_klass, "get_unsigned_short_array", sd_get_unsigned_short_array, -1);
+  rb_define_method(sd_memory_klass, "set_unsigned_short_array", sd_set_unsigned_short_array, -1);
+  rb_define_method(sd_memory_klass, "get_char_array", sd_get_char_array, -1);
+  rb_define_method(sd_memory_klass, "set_char_array", sd_set_char_array, -1);
+  rb_define_method(sd_memory_klass, "get_unsigned_char_array", sd_get_unsigned_char_array, -1);
+  rb_define_method(sd_memory_klass, "set_unsigned_char_array", sd_set_unsigned_char_array, -1);
+  rb_define_method(sd_memory_klass, "get_signed_char_array", sd_get_signed_char_array, -1);
+  rb_define_method(sd_memory_klass, "set_signed_char_array", sd_set_signed_char_array, -1);
+  rb_define_method(sd_memory_klass, "reduce_sum", sd_memory_reduce_sum, -1);
+  rb_define_method(sd_memory_klass, "reduce_min", sd_memory_reduce_min, -1);
+  rb_define_method(sd_memory_klass, "reduce_max", sd_memory_reduce_max, -1);
+  rb_define_method(sd_memory_klass, "reduce_mean", sd_memory_reduce_mean, -1);
+  rb_define_method(sd_memory_klass, "reduce_dot", sd_memory_reduce_dot, -1);
+  rb_define_private_method(sd_memory_klass, "__sort_records__", sd_memory_sort_records, 5);
+  rb_define_method(sd_memory_klass, "eql_content?", sd_memory_eql_content, -1);
+  rb_define_method(sd_memory_klass, "content_hash", sd_memory_content_hash, -1);
+  rb_define_method(sd_memory_klass, "crc32c", sd_memory_crc32c, -1);
+  rb_define_method(sd_memory_klass, "view", sd_memory_view, -1);
+  #ifdef SD_HAS_MEMORY_VIEW
+  sd_id_memory_view_format = rb_intern("__memory_view_format__");
+  sd_id_memory_view_bytesize = rb_intern("__memory_view_bytesize__");
+  rb_memory_view_register(sd_memory_klass, &sd_memory_view_entry);
+  #endif
   rb_define_method(sd_memory_klass, "get_string", sd_get_string, -1);
   rb_define_method(sd_memory_klass, "set_string", sd_set_string, -1);
+
+  sd_arena_klass = rb_define_class_under(sd_snow_module, "Arena", rb_cObject);
+  rb_define_alloc_func(sd_arena_klass, sd_arena_alloc);
+  rb_define_method(sd_arena_klass, "initialize", sd_arena_initialize, -1);
+  rb_define_method(sd_arena_klass, "reset!", sd_arena_reset, 0);
+  rb_define_method(sd_arena_klass, "release!", sd_arena_release, 0);
+  rb_define_method(sd_arena_klass, "bytesize", sd_arena_bytesize, 0);
+  rb_define_method(sd_arena_klass, "capacity", sd_arena_capacity, 0);
+  rb_define_method(sd_arena_klass, "chunk_size", sd_arena_chunk_size, 0);
+  rb_define_private_method(sd_arena_klass, "__allocate__", sd_arena_allocate_m, 2);
+  rb_define_private_method(sd_arena_klass, "__track__", sd_arena_track, 1);
+  rb_define_private_method(sd_arena_klass, "__track_view__", sd_arena_track_view, 1);
+  rb_define_private_method(sd_arena_klass, "__wrap_new__", sd_arena_wrap_new, 3);
+
+  sd_pool_klass = rb_define_class_under(sd_snow_module, "Pool", rb_cObject);
+  rb_define_alloc_func(sd_pool_klass, sd_pool_alloc);
+  rb_define_method(sd_pool_klass, "initialize", sd_pool_initialize, -1);
+  rb_define_method(sd_pool_klass, "alloc", sd_pool_alloc_m, -1);
+  rb_define_method(sd_pool_klass, "stats", sd_pool_stats, 0);
+  rb_define_method(sd_pool_klass, "size", sd_pool_size, 0);
+  rb_define_method(sd_pool_klass, "alignment", sd_pool_alignment, 0);
 }
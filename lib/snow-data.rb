@@ -6,3 +6,4 @@ require 'snow-data/version'
 require 'snow-data/snowdata_bindings'
 require 'snow-data/c_struct'
 require 'snow-data/memory'
+require 'snow-data/arena'
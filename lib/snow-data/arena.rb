@@ -0,0 +1,104 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'snow-data/snowdata_bindings'
+require 'snow-data/memory'
+
+module Snow ; end
+
+
+#
+# An arena allocates Memory blocks, structs, and struct arrays by bumping a
+# pointer through large chunks of memory rather than allocating each one on
+# its own. Nothing allocated from an arena is freed individually. Instead, the
+# arena is reset or released all at once, which makes it a good fit for
+# short-lived, per-frame scratch data.
+#
+# Objects allocated from an arena don't own their memory. Each keeps the arena
+# alive for as long as it is, and resetting or releasing the arena invalidates
+# all of them (as though free! were called on each), so a stale object holds a
+# NULL block rather than a dangling pointer. Memory allocated from an arena is
+# always zeroed.
+#
+# For example:
+#
+#   arena = Snow::Arena.new
+#   loop {
+#     arena.scope {
+#       scratch = arena.struct(Vec3)
+#       points  = arena.array(Vec3, 64)
+#       # ...
+#     }
+#   }
+#
+class Snow::Arena
+
+  #
+  # call-seq:
+  #     alloc(bytesize, alignment = nil) => Memory
+  #
+  # Allocates a zeroed Memory block of the given size and alignment from the
+  # arena. If no alignment is given, it defaults to
+  # Snow::Memory::SIZEOF_VOID_POINTER. Alignments may be at most 64.
+  #
+  def alloc(bytesize, alignment = nil)
+    alignment ||= ::Snow::Memory::SIZEOF_VOID_POINTER
+    __wrap_new__(::Snow::Memory, bytesize, alignment)
+  end
+
+
+  #
+  # call-seq:
+  #     struct(struct_klass) => struct
+  #     struct(struct_klass) { |struct| ... } => struct
+  #
+  # Allocates a zeroed struct of the given CStruct type from the arena. If a
+  # block is given, the struct is yielded to it before it's returned.
+  #
+  def struct(struct_klass)
+    inst = __wrap_new__(struct_klass, struct_klass::SIZE, struct_klass::ALIGNMENT)
+    yield(inst) if block_given?
+    inst
+  end
+
+
+  #
+  # call-seq:
+  #     array(struct_klass, length) => struct_array
+  #
+  # Allocates a zeroed array of length structs of the given CStruct type from
+  # the arena.
+  #
+  def array(struct_klass, length)
+    length = length.to_i
+    raise ArgumentError, "Length must be greater than zero" if length < 1
+    __track__(struct_klass::Array.wrap(
+      __allocate__(struct_klass::SIZE * length, struct_klass::ALIGNMENT),
+      length))
+  end
+
+
+  #
+  # call-seq:
+  #     scope { |arena| ... } => obj
+  #
+  # Yields the arena to the block and resets it once the block is done,
+  # whether or not it raised an exception. Returns the result of the block.
+  #
+  def scope
+    yield self
+  ensure
+    reset!
+  end
+
+
+  #
+  # Returns a string showing the arena's classname, object ID, the number of
+  # bytes allocated from it, and its capacity.
+  #
+  def inspect
+    "<#{self.class}:0x#{__id__.to_s(16).rjust(14, ?0)} #{bytesize}/#{capacity}>"
+  end
+
+end # class Arena
@@ -6,6 +6,8 @@ require 'snow-data/snowdata_bindings'
 require 'snow-data/memory'
 require 'snow-data/c_struct/struct_base'
 require 'snow-data/c_struct/array_base'
+require 'snow-data/c_struct/soa_base'
+require 'snow-data/c_struct/vector_base'
 require 'snow-data/c_struct/builder'
 
 module Snow
@@ -178,6 +180,41 @@ class CStruct
   }
 
 
+  # Memory subclasses for types added through ::add_type, used for struct
+  # members of those types.
+  CLASSES = {}
+
+
+  # MemoryView format specifiers (pack template directives) for default types.
+  MEMORY_VIEW_TYPES = {
+    :char                 => 'c',
+    :signed_char          => 'c',
+    :unsigned_char        => 'C',
+    :uint8_t              => 'C',
+    :int8_t               => 'c',
+    :short                => 's!',
+    :unsigned_short       => 'S!',
+    :uint16_t             => 'S',
+    :int16_t              => 's',
+    :int32_t              => 'l',
+    :uint32_t             => 'L',
+    :uint64_t             => 'Q',
+    :int64_t              => 'q',
+    :unsigned_long        => 'L!',
+    :unsigned_long_long   => 'Q!',
+    :long                 => 'l!',
+    :long_long            => 'q!',
+    :int                  => 'i!',
+    :unsigned_int         => 'I!',
+    :float                => 'f',
+    :double               => 'd',
+    :size_t               => 'J',
+    :ptrdiff_t            => 'j',
+    :intptr_t             => 'j',
+    :uintptr_t            => 'J'
+  }
+
+
   # Used for getters/setters on Memory objects. Simply maps short type names to
   # their long-form type names.
   TYPE_ALIASES = {
@@ -268,6 +305,7 @@ class CStruct
 
     ALIGNMENTS[name] = klass::ALIGNMENT
     SIZES[name]      = klass::SIZE
+    CLASSES[name]    = klass
 
     getter = :"get_#{name}"
     setter = :"set_#{name}"
@@ -277,11 +315,17 @@ class CStruct
       define_method(getter) do |offset|
         wrapper = klass.__wrap__(self.address + offset, klass::SIZE, klass::ALIGNMENT)
         wrapper.instance_variable_set(:@__base_memory__, self)
+        # Let a struct vector this lives in move the wrapper with its block
+        if (root = @__view_root__)
+          wrapper.instance_variable_set(:@__view_root__, root)
+          root.__send__(:__track_view__, wrapper)
+        end
+        wrapper.__send__(:__readonly_view_of__, self)
         wrapper
       end # getter
 
       define_method(setter) do |offset, data|
-        raise "Invalid value type, must be Data, but got #{data.class}" if ! data.kind_of?(Data)
+        raise "Invalid value type, must be Memory, but got #{data.class}" if ! data.kind_of?(Memory)
         local_addr = self.address + offset
         if ! data.respond_to?(:address) || local_addr != data.address
           copy!(data, offset, 0, klass::SIZE)
@@ -416,6 +460,13 @@ class CStruct
   # `fetch(index)` and `store(index, value)` methods, both aliased to `[]` and
   # `[]=` respectively.
   #
+  # Struct classes also have an SoA class (as `StructKlass::SoA`) that stores
+  # arrays of structs as one contiguous column per member rather than one
+  # struct after another. See StructSoABase for more on those.
+  #
+  # Finally, struct classes have a Vector class (as `StructKlass::Vector`), a
+  # growable array with amortized `push` and `pop`. See StructVectorBase.
+  #
   def self.new(*args, &block)
     klass_name = nil
     encoding = nil
@@ -567,6 +618,40 @@ class CStruct
   end
 
 
+  #
+  # call-seq:
+  #   memory_view_format(members, size) => String
+  #
+  # Returns a MemoryView format string for a struct of the given size with the
+  # given array of StructMemberInfo objects. Padding between and after members
+  # is written out as 'x' bytes, so the format's item size is always size.
+  # Members of struct types are inlined, once per element.
+  #
+  # Members that overlap (i.e., those of unions) can't be described by a
+  # format, so the struct is then described as size unsigned bytes. Members of
+  # types added via ::add_type that aren't structs are described as unsigned
+  # bytes as well.
+  #
+  def self.memory_view_format(members, size)
+    format = ''
+    offset = 0
+    members.sort_by(&:offset).each { |member|
+      return "C#{size}" if member.offset < offset
+      format << "x#{member.offset - offset}" if member.offset > offset
+      if (type_format = MEMORY_VIEW_TYPES[member.type])
+        format << (member.length > 1 ? "#{type_format}#{member.length}" : type_format)
+      elsif (klass = CLASSES[member.type]) && klass.const_defined?(:MEMORY_VIEW_FORMAT)
+        format << klass::MEMORY_VIEW_FORMAT * member.length
+      else
+        format << "C#{member.size}"
+      end
+      offset = member.offset + member.size
+    }
+    format << "x#{size - offset}" if size > offset
+    format
+  end
+
+
   #
   # call-seq:
   #   build_struct_type(members) => Class
@@ -602,6 +687,7 @@ class CStruct
       const_set(:SIZE,          type_size)
       const_set(:ALIGNED_SIZE,  aligned_size)
       const_set(:ALIGNMENT,     alignment)
+      const_set(:MEMORY_VIEW_FORMAT, CStruct.memory_view_format(members, type_size).freeze)
 
       const_set(:MEMBERS_HASH,  members.reduce({}) { |hash, member|
         hash[member.name] = member
@@ -623,8 +709,10 @@ class CStruct
 
       include StructBase
 
-      # Build and define the struct type's array class.
-      const_set(:Array, CStruct.build_array_type(self))
+      # Build and define the struct type's array classes.
+      const_set(:Array,   CStruct.build_array_type(self))
+      const_set(:SoA,     CStruct.build_soa_type(self))
+      const_set(:Vector,  CStruct.build_vector_type(self))
     end
 
   end
@@ -646,6 +734,38 @@ class CStruct
   end # build_array_type
 
 
+  #
+  # :nodoc:
+  # Generates a structure-of-arrays class for the given struct class. This is
+  # called by ::build_struct_type and so shouldn't be called manually.
+  #
+  def self.build_soa_type(struct_klass)
+    Class.new(Memory) do |soa_klass|
+      const_set(:BASE, struct_klass)
+
+      private :realloc!
+
+      include StructSoABase
+    end # Class.new
+  end # build_soa_type
+
+
+  #
+  # :nodoc:
+  # Generates a growable vector class for the given struct class. This is
+  # called by ::build_struct_type and so shouldn't be called manually.
+  #
+  def self.build_vector_type(struct_klass)
+    Class.new(Memory) do |vector_klass|
+      const_set(:BASE, struct_klass)
+
+      private :realloc!
+
+      include StructVectorBase
+    end # Class.new
+  end # build_vector_type
+
+
   class <<self ; alias_method :[], :new ; end
 
   Builder.flush_type_methods!
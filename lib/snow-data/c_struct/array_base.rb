@@ -13,8 +13,13 @@ class Snow::CStruct ; end
 #
 # Array base for struct type arrays. Provides fetch/store and allocators.
 #
-# Fetch and store operations both depend on an internal cache of wrapper Memory
-# objects that point to structs in the array.
+# Fetch operations depend on an internal cache of wrapper Memory objects that
+# point to structs in the array. Wrappers are only created for the indices that
+# are actually fetched.
+#
+# If cursor_mode is enabled, iterating over the array instead yields a single
+# reusable wrapper (a cursor) that's moved from element to element, so no
+# per-element objects are created at all.
 #
 module Snow::CStruct::StructArrayBase
 
@@ -22,7 +27,8 @@ module Snow::CStruct::StructArrayBase
 
 
   def self.included(array_klass)
-    array_klass.extend(Allocators)
+    # StructVectorBase includes this module too, but has its own allocators
+    array_klass.extend(Allocators) if array_klass.kind_of?(Class)
   end
 
 
@@ -33,6 +39,19 @@ module Snow::CStruct::StructArrayBase
   attr_reader :length
 
 
+  #
+  # Whether #each, #map!, and anything built on #each (e.g., each_with_index)
+  # yield a single cursor object that's moved to each element in turn rather
+  # than a cached wrapper per element. Disabled by default.
+  #
+  # The cursor is only valid for the iteration it was yielded for. Don't keep
+  # it around or return it from Enumerable methods that collect elements (e.g.,
+  # select) -- after iteration, it points to NULL. Use #fetch to get a wrapper
+  # that stays valid.
+  #
+  attr_accessor :cursor_mode
+
+
   def resize!(new_length) # :nodoc:
     raise ArgumentError, "Length must be greater than zero" if new_length < 1
     realloc!(new_length * self.class::BASE::SIZE, self.class::BASE::ALIGNMENT)
@@ -44,7 +63,11 @@ module Snow::CStruct::StructArrayBase
 
   def each(&block) # :nodoc:
     return to_enum(:each) unless block_given?
-    (0 ... self.length).each { |index| yield fetch(index) }
+    if @cursor_mode
+      __each_cursor__ { |cursor, index| yield cursor }
+    else
+      (0 ... self.length).each { |index| yield fetch(index) }
+    end
     self
   end
 
@@ -57,11 +80,125 @@ module Snow::CStruct::StructArrayBase
 
   def map!(&block) # :nodoc:
     return to_enum(:map!) unless block_given?
-    (0 ... self.length).each { |index| store(index, yield(fetch(index))) }
+    if @cursor_mode
+      __each_cursor__ { |cursor, index| store(index, yield(cursor)) }
+    else
+      (0 ... self.length).each { |index| store(index, yield(fetch(index))) }
+    end
+    self
+  end
+
+
+  def dup # :nodoc:
+    self.class.new(@length).copy!(self)
+  end
+
+
+  #
+  # Returns a new structure-of-arrays copy of the array. See
+  # StructSoABase.
+  #
+  def to_soa
+    self.class::BASE::SoA.from_array(self)
+  end
+
+
+  #
+  # call-seq:
+  #     member_sum(*path) => Numeric
+  #     member_min(*path) => Numeric or nil
+  #     member_max(*path) => Numeric or nil
+  #     member_mean(*path) => Float or nil
+  #
+  # Reduces a primitive member across every struct in the array without
+  # creating a wrapper for each struct. See Memory#reduce_sum and friends for
+  # how sums are accumulated.
+  #
+  # The path names the member to reduce. It's a member name, followed by an
+  # element index for members with a length greater than 1, and further member
+  # names and indices for members of nested struct types. For example, given a
+  # struct with a member +position+ of type +vec3+, +member_sum(:position, :x)+
+  # sums the x component of every position. Raises an ArgumentError if the path
+  # ends at a member with a length greater than 1 without an element index.
+  #
+  def member_sum(*path)
+    __member_reduce__(:reduce_sum, path)
+  end
+
+  def member_min(*path) # :nodoc:
+    __member_reduce__(:reduce_min, path)
+  end
+
+  def member_max(*path) # :nodoc:
+    __member_reduce__(:reduce_max, path)
+  end
+
+  def member_mean(*path) # :nodoc:
+    __member_reduce__(:reduce_mean, path)
+  end
+
+
+  #
+  # call-seq:
+  #     member_dot(path, other) => Numeric
+  #     member_dot(path, other, other_path) => Numeric
+  #
+  # Returns the dot product of a primitive member of every struct in the array
+  # and a primitive member of every struct in other, another struct array of at
+  # least the same length. Paths are given as for #member_sum, either as a
+  # single member name or an Array. If other_path is omitted, it's the same as
+  # path. Both members must be of the same type.
+  #
+  def member_dot(path, other, other_path = path)
+    raise TypeError, "Expected a struct array, got #{other.class}" if ! other.kind_of?(::Snow::CStruct::StructArrayBase)
+    raise RangeError, "Other array is shorter than #{self.class}" if other.length < @length
+    type, offset = __member_scalar_path__(self.class::BASE, Array(path))
+    other_type, other_offset = __member_scalar_path__(other.class::BASE, Array(other_path))
+    raise TypeError, "Member types #{type} and #{other_type} differ" if type != other_type
+    reduce_dot(type, offset, other, other_offset, @length,
+               self.class::BASE::SIZE, other.class::BASE::SIZE)
+  end
+
+
+  #
+  # call-seq:
+  #     sort_by_member!(*paths, descending: false) => self
+  #
+  # Sorts the structs in the array in place by one or more primitive members,
+  # without creating a wrapper for each struct. Paths are given as for
+  # #member_sum, either as a single member name or an Array. Structs are
+  # ordered by their first member, then their second, and so on, and structs
+  # that compare equal keep their relative order. A member with a length
+  # greater than 1 named without an element index is compared element by
+  # element.
+  #
+  # Integer and float keys totalling 8 bytes or less are radix sorted, and
+  # wider keys are compared with an introsort. Floats order by value, with
+  # -0.0 before 0.0 and NaNs after infinity (or before negative infinity, if
+  # their sign bit is set). Large arrays are sorted without holding the GVL.
+  #
+  # Structs fetched from the array before sorting still refer to the same
+  # index, not the same struct.
+  #
+  def sort_by_member!(*paths, descending: false)
+    raise FrozenError, "can't modify frozen #{self.class}" if frozen?
+    __sort_records__(__sort_keys__(paths), @length, self.class::BASE::SIZE, descending, true)
     self
   end
 
 
+  #
+  # call-seq:
+  #     argsort(*paths, descending: false) => Array
+  #
+  # Returns an Array of the indices of the structs in the array in the order
+  # #sort_by_member! would put them in, leaving the array as it is.
+  #
+  def argsort(*paths, descending: false)
+    __sort_records__(__sort_keys__(paths), @length, self.class::BASE::SIZE, descending, false)
+  end
+
+
   def to_a # :nodoc:
     (0 ... self.length).map { |index| fetch(index) }
   end
@@ -70,14 +207,14 @@ module Snow::CStruct::StructArrayBase
   def fetch(index) # :nodoc:
     raise RuntimeError, "Attempt to access deallocated array" if @length == 0
     raise RangeError, "Attempt to access out-of-bounds index in #{self.class}" if index < 0 || @length <= index
-    __build_cache__ if ! @__cache__
-    @__cache__[index]
+    @__cache__ ||= {}
+    @__cache__[index] ||= __build_wrapper__(index)
   end
   alias_method :[], :fetch
 
 
   #
-  # You can use this to assign _any_ Data subclass to an array value, but
+  # You can use this to assign _any_ Memory subclass to an array value, but
   # keep in mind that the data assigned MUST -- again, MUST -- be at least
   # as large as the array's base struct type in bytes or the assigned
   # data object MUST respond to a bytesize message to get its size in
@@ -85,9 +222,10 @@ module Snow::CStruct::StructArrayBase
   #
   def store(index, data) # :nodoc:
     raise RuntimeError, "Attempt to access deallocated array" if @length == 0
-    raise TypeError, "Invalid value type, must be Data, but got #{data.class}" if ! data.kind_of?(Data)
+    raise TypeError, "Invalid value type, must be Memory, but got #{data.class}" if ! data.kind_of?(::Snow::Memory)
     raise RangeError, "Attempt to access out-of-bounds index in #{self.class}" if index < 0 || @length <= index
-    @__cache__[index].copy!(data)
+    size = self.class::BASE::SIZE
+    copy!(data, index * size, 0, size)
     data
   end
   alias_method :[]=, :store
@@ -101,11 +239,31 @@ module Snow::CStruct::StructArrayBase
   end
 
 
+  #
+  # Unmaps an array created by ::map. Structs fetched from the array are left
+  # pointing at NULL.
+  #
+  def unmap!
+    raise FrozenError, "can't unmap frozen #{self.class}" if frozen?
+    super
+    __free_cache__
+    @length = 0
+    self
+  end
+
+
   private
 
+  # Used by the extension to describe the array's MemoryView, one struct per
+  # element.
+  def __memory_view_format__ # :nodoc:
+    self.class::BASE::MEMORY_VIEW_FORMAT
+  end
+
+
   def __free_cache__ # :nodoc:
     if @__cache__
-      @__cache__.each { |entry|
+      @__cache__.each_value { |entry|
         entry.free!
         entry.remove_instance_variable(:@__base_memory__)
       } # zeroes address, making it NULL
@@ -114,14 +272,84 @@ module Snow::CStruct::StructArrayBase
   end
 
 
-  def __build_cache__ # :nodoc:
-    addr = self.address
-    @__cache__ = (0...length).map { |index|
-      wrapper = self.class::BASE.__wrap__(addr + index * self.class::BASE::SIZE, self.class::BASE::SIZE)
-      # Make sure the wrapped object keeps the memory from being collected while it's in use
-      wrapper.instance_variable_set(:@__base_memory__, self)
-      wrapper
-    }
+  def __build_wrapper__(index) # :nodoc:
+    base = self.class::BASE
+    wrapper = base.__wrap__(self.address + index * base::SIZE, base::SIZE)
+    # Make sure the wrapped object keeps the memory from being collected while it's in use
+    wrapper.instance_variable_set(:@__base_memory__, self)
+    # Let whatever the array's memory came from (e.g., an Arena) null the
+    # wrapper along with the array
+    if (root = @__view_root__)
+      wrapper.instance_variable_set(:@__view_root__, root)
+      root.__send__(:__track_view__, wrapper)
+    end
+    wrapper.__send__(:__readonly_view_of__, self)
+    wrapper
+  end
+
+
+  def __member_reduce__(reducer, path) # :nodoc:
+    raise RuntimeError, "Attempt to access deallocated array" if @length == 0
+    type, offset = __member_scalar_path__(self.class::BASE, path)
+    __send__(reducer, type, offset, @length, self.class::BASE::SIZE)
+  end
+
+
+  # Resolves a member path as #__member_path__ does, but only to a single
+  # value, so paths ending at a member with a length greater than 1 need an
+  # element index.
+  def __member_scalar_path__(struct_klass, path) # :nodoc:
+    type, offset, length = __member_path__(struct_klass, path)
+    if length > 1
+      raise ArgumentError, "Member #{path.last} has #{length} elements -- give an element index"
+    end
+    [type, offset]
+  end
+
+
+  def __sort_keys__(paths) # :nodoc:
+    raise ArgumentError, "No member given" if paths.empty?
+    paths.map { |path| __member_path__(self.class::BASE, Array(path)) }
+  end
+
+
+  # Resolves a member path to the primitive type and offset it names in a
+  # struct of the given type, and the number of values it covers: the member's
+  # length, or 1 if the path ends with an element index. Members with more than
+  # one element must be followed by an index unless they end the path.
+  def __member_path__(struct_klass, path) # :nodoc:
+    raise ArgumentError, "No member given" if path.empty?
+    offset = 0
+    path = path.dup
+    until path.empty?
+      raise TypeError, "#{struct_klass} is not a struct type" if struct_klass.nil?
+      name = path.shift
+      info = struct_klass::MEMBERS_HASH.fetch(name) {
+        raise ArgumentError, "#{struct_klass} has no member #{name}"
+      }
+      offset += info.offset
+      length = info.length
+      if path.first.kind_of?(Integer)
+        element = path.shift
+        raise RangeError, "Element #{element} for #{name} is out of range" if element < 0 || info.length <= element
+        offset += element * (info.size / info.length)
+        length = 1
+      elsif length > 1 && !path.empty?
+        raise ArgumentError, "Member #{name} has #{length} elements -- give an element index"
+      end
+      type = info.type
+      struct_klass = ::Snow::CStruct::CLASSES[type]
+    end
+    raise TypeError, "Member #{name} is not a primitive type" if struct_klass
+    [type, offset, length]
+  end
+
+
+  def __each_cursor__(&block) # :nodoc:
+    return self if @length == 0
+    base = self.class::BASE
+    cursor = __build_wrapper__(0)
+    __each_view__(cursor, base::SIZE, @length, &block)
   end
 
 end # module StructArrayBase
@@ -131,7 +359,10 @@ end # module StructArrayBase
 module Snow::CStruct::StructArrayBase::Allocators
 
   def wrap(address, length_in_elements) # :nodoc:
-    __wrap__(address, length_in_elements * self::BASE::SIZE)
+    inst = __wrap__(address, length_in_elements * self::BASE::SIZE)
+    inst.instance_variable_set(:@length, length_in_elements)
+    inst.instance_variable_set(:@__cache__, nil)
+    inst
   end
 
 
@@ -157,6 +388,32 @@ module Snow::CStruct::StructArrayBase::Allocators
   end
 
 
+  if ::Snow::Memory::HAS_MMAP
+    #
+    # call-seq:
+    #     map(path, offset: 0, length: nil, mode: :read) => Struct::Array
+    #
+    # Maps a file of structs into memory as an array of length structs,
+    # starting at offset bytes into the file. If length is nil, the array
+    # covers as many whole structs as fit in the rest of the file. See
+    # Snow::Memory::map for modes. Arrays mapped with :read are read-only, as
+    # are the structs fetched from them.
+    #
+    # The mapping is unmapped when the array is freed, by free!, unmap!, or
+    # the GC.
+    #
+    def map(path, offset: 0, length: nil, mode: :read)
+      size = self::BASE::SIZE
+      length ||= (File.size(path) - offset) / size
+      raise ArgumentError, "Length must be greater than zero" if length < 1
+      inst = __map__(path, offset, length * size, mode)
+      inst.instance_variable_set(:@length, length)
+      inst.instance_variable_set(:@__cache__, {})
+      inst
+    end
+  end
+
+
   alias_method :[], :new
 
 end # module Allocators
@@ -0,0 +1,227 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'snow-data/memory'
+
+
+module Snow ; end
+
+class Snow::CStruct ; end
+
+
+#
+# Base for structure-of-arrays struct types. Where a struct's Array class stores
+# each struct one after the other, its SoA class stores each member of the
+# struct in its own contiguous column. Passes that only read one or two members
+# of every struct then only touch the memory for those members.
+#
+# Columns are laid out in a single block in the order of the struct's members,
+# each aligned to its member's alignment. A column holds length elements of
+# its member's full size, so a member declared as float[4] has four floats per
+# element in its column.
+#
+module Snow::CStruct::StructSoABase
+
+  module Allocators ; end
+
+
+  def self.included(soa_klass)
+    soa_klass.extend(Allocators)
+  end
+
+
+  # The length of the array in structs.
+  attr_reader :length
+
+
+  #
+  # Returns the offset in bytes of a member's column.
+  #
+  def column_offset(member)
+    @__column_offsets__.fetch(member)
+  end
+
+
+  #
+  # Returns the size in bytes of a member's column.
+  #
+  def column_bytesize(member)
+    self.class::BASE::MEMBERS_HASH.fetch(member).size * @length
+  end
+
+
+  #
+  # call-seq:
+  #     get_column(member) => Array
+  #
+  # Returns an Array of every value in a member's column. For members with a
+  # length greater than 1, the values of each struct's member are adjacent
+  # (i.e., the array holds length * member_length values).
+  #
+  # Raises a TypeError if the member isn't of a primitive type.
+  #
+  def get_column(member)
+    info = __column_member__(member)
+    __send__(:"get_#{info.type}_array", column_offset(member), @length * info.length)
+  end
+
+
+  #
+  # call-seq:
+  #     set_column(member, values) => values
+  #
+  # Writes an Array of values into a member's column, starting at the first
+  # struct. Values are laid out as returned by #get_column.
+  #
+  # Raises a TypeError if the member isn't of a primitive type and a RangeError
+  # if there are more values than the column can hold.
+  #
+  def set_column(member, values)
+    info = __column_member__(member)
+    if values.length > @length * info.length
+      raise RangeError, "#{values.length} values do not fit in column #{member} of #{self.class}"
+    end
+    __send__(:"set_#{info.type}_array", column_offset(member), values)
+  end
+
+
+  #
+  # Gets the value of a member of the struct at the given index. If the member
+  # has a length greater than 1, element selects which of its values to get.
+  #
+  def get(member, index, element = 0)
+    info = self.class::BASE::MEMBERS_HASH.fetch(member)
+    __send__(:"get_#{info.type}", __value_offset__(info, index, element))
+  end
+
+
+  #
+  # Sets the value of a member of the struct at the given index and returns
+  # the value. If the member has a length greater than 1, element selects which
+  # of its values to set.
+  #
+  def set(member, index, value, element = 0)
+    info = self.class::BASE::MEMBERS_HASH.fetch(member)
+    __send__(:"set_#{info.type}", __value_offset__(info, index, element), value)
+    value
+  end
+
+
+  #
+  # Copies the contents of a struct Array or Vector of the same struct type and
+  # length into the receiver's columns. Returns self.
+  #
+  def copy_from_array!(array)
+    base = self.class::BASE
+    if ! array.kind_of?(::Snow::CStruct::StructArrayBase) || array.class::BASE != base
+      raise TypeError, "Expected #{base::Array}, got #{array.class}"
+    end
+    raise ArgumentError, "Array length #{array.length} does not match #{@length}" if array.length != @length
+    base::MEMBERS.each { |member|
+      copy_strided!(array, member.size, @length,
+                    column_offset(member.name), member.size,
+                    member.offset, base::SIZE)
+    }
+    self
+  end
+
+
+  #
+  # Returns a new struct Array holding the same structs as the receiver.
+  #
+  def to_array
+    base = self.class::BASE
+    array = base::Array.new(@length)
+    base::MEMBERS.each { |member|
+      array.copy_strided!(self, member.size, @length,
+                          member.offset, base::SIZE,
+                          column_offset(member.name), member.size)
+    }
+    array
+  end
+
+
+  def dup # :nodoc:
+    self.class.new(@length).copy!(self)
+  end
+
+
+  def free! # :nodoc:
+    @length = 0
+    super
+  end
+
+
+  private
+
+  def __column_member__(member) # :nodoc:
+    info = self.class::BASE::MEMBERS_HASH.fetch(member)
+    if ::Snow::CStruct::CLASSES.include?(info.type)
+      raise TypeError, "Column #{member} of #{self.class} is not a primitive type"
+    end
+    info
+  end
+
+
+  def __value_offset__(info, index, element) # :nodoc:
+    raise RuntimeError, "Attempt to access deallocated array" if @length == 0
+    raise RangeError, "Attempt to access out-of-bounds index in #{self.class}" if index < 0 || @length <= index
+    raise RangeError, "Element #{element} for #{info.name} is out of range" if element < 0 || info.length <= element
+    type_size = info.size / info.length
+    column_offset(info.name) + index * info.size + element * type_size
+  end
+
+end # module StructSoABase
+
+
+
+module Snow::CStruct::StructSoABase::Allocators
+
+  #
+  # Returns a pair of a Hash of member names to their column offsets and the
+  # total size in bytes of the columns for an SoA array of the given length.
+  #
+  def column_layout(length)
+    offset = 0
+    offsets = self::BASE::MEMBERS.each_with_object({}) { |member, hash|
+      offset = ::Snow::Memory.align_size(offset, member.alignment)
+      hash[member.name] = offset
+      offset += member.size * length
+    }
+    [offsets, offset]
+  end
+
+
+  def wrap(address, length) # :nodoc:
+    offsets, size = column_layout(length)
+    inst = __wrap__(address, size, self::BASE::ALIGNMENT)
+    inst.instance_variable_set(:@length, length)
+    inst.instance_variable_set(:@__column_offsets__, offsets)
+    inst
+  end
+
+
+  def new(length) # :nodoc:
+    length = length.to_i
+    raise ArgumentError, "Length must be greater than zero" if length < 1
+    offsets, size = column_layout(length)
+    inst = __malloc__(size, self::BASE::ALIGNMENT)
+    inst.instance_variable_set(:@length, length)
+    inst.instance_variable_set(:@__column_offsets__, offsets)
+    inst
+  end
+
+
+  #
+  # Allocates a new SoA array with the contents of a struct Array or Vector of
+  # the same struct type.
+  #
+  def from_array(array)
+    new(array.length).copy_from_array!(array)
+  end
+
+
+  alias_method :[], :new
+
+end # module Allocators
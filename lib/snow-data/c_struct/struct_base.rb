@@ -145,45 +145,37 @@ module Snow::CStruct::StructBase
   end
 
 
+  private
+
+  # Used by the extension to describe the struct's MemoryView.
+  def __memory_view_format__ # :nodoc:
+    self.class::MEMORY_VIEW_FORMAT
+  end
+
+
+  #
+  # Defines get_<member>/set_<member> methods for each of the struct class's
+  # members, along with their <member>/<member>= aliases. The accessors
+  # themselves are implemented by the extension, which is given each member's
+  # offset, type, and length here.
+  #
   def self.define_member_methods(struct_klass)
     struct_klass.class_exec do
       self::MEMBERS.each do |member|
 
         name        = member.name
-        index_range = (0...member.length)
         type_name   = member.type
-        type_size   = ::Snow::CStruct::SIZES[member.type]
-        offset      = member.offset
-        getter      = :"get_#{type_name}"
-        setter      = :"set_#{type_name}"
-        get_name    = :"get_#{name}"
-        set_name    = :"set_#{name}"
-
-        define_method(get_name) do |index = 0|
-          if index === index_range
-            raise RangeError, "Index #{index} for #{name} is out of range: must be in #{index_range}"
-          end
-          off = offset + index * type_size
-          __send__(getter, off)
-        end # get_name
+        type_size   = ::Snow::CStruct::SIZES[type_name]
+        type_klass  = ::Snow::CStruct::CLASSES[type_name]
 
+        __define_member__(name, type_name, member.offset, member.length, type_size, type_klass)
 
-        define_method(set_name) do |value, index = 0|
-          if index === index_range
-            raise RangeError, "Index #{index} for #{name} is out of range: must be in #{index_range}"
-          end
-          off = offset + index * type_size
-          __send__(setter, off, value)
-          value
-        end # set_name
-
-
-        alias_method :"#{name}", get_name
-        alias_method :"#{name}=", set_name
-
-        extend MemberInfoSupport
+        alias_method :"#{name}", :"get_#{name}"
+        alias_method :"#{name}=", :"set_#{name}"
 
       end # self::MEMBERS.each
+
+      extend MemberInfoSupport
     end # self.class_exec
   end # define_member_methods!
 
@@ -216,12 +208,51 @@ module Snow::CStruct::StructBase::Allocators
   # is first yielded to the block then returned. You may use this to initialize
   # the block or do whatever else you like with it.
   #
+  # If the struct type uses a pool (see ::use_pool!), the new struct is
+  # allocated from the pool.
+  #
   def new(&block)
-    inst = __malloc__(self::SIZE, self::ALIGNMENT)
+    inst = if @__pool__
+      @__pool__.alloc(self)
+    else
+      __malloc__(self::SIZE, self::ALIGNMENT)
+    end
     yield(inst) if block_given?
     inst
   end
 
+  #
+  # call-seq:
+  #     use_pool!(slots_per_slab = nil) => Snow::Pool
+  #
+  # Makes ::new allocate structs of this type from a Snow::Pool rather than
+  # allocating each one on its own, and returns the pool. Pooled structs are
+  # only padded out to the struct's alignment and are returned to the pool when
+  # freed, which saves a great deal of memory for small structs. If the type
+  # already uses a pool, that pool is returned.
+  #
+  # See Snow::Pool.new for slots_per_slab.
+  #
+  def use_pool!(slots_per_slab = nil)
+    @__pool__ ||= ::Snow::Pool.new(self::SIZE, self::ALIGNMENT, slots_per_slab)
+  end
+
+  #
+  # Returns the Snow::Pool structs of this type are allocated from, or nil if
+  # the type doesn't use a pool.
+  #
+  def pool
+    @__pool__
+  end
+
+  #
+  # Returns the statistics of the struct type's pool (see Snow::Pool#stats), or
+  # nil if the type doesn't use a pool.
+  #
+  def pool_stats
+    @__pool__ && @__pool__.stats
+  end
+
   if ::Snow::Memory::HAS_ALLOCA
     def alloca(&block)
       __alloca__(self::SIZE, &block)
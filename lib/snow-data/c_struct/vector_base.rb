@@ -0,0 +1,392 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'snow-data/memory'
+require 'snow-data/c_struct/array_base'
+
+
+module Snow ; end
+
+class Snow::CStruct ; end
+
+
+#
+# Base for growable struct vectors. A vector is a struct Array whose block has
+# room for capacity structs, of which the first length are in use. Pushing onto
+# a full vector grows its capacity geometrically (doubling it), so appending n
+# structs reallocates the block O(log n) times rather than n times.
+#
+# Structs fetched from a vector, and the nested struct members fetched from
+# those, stay valid when its block is reallocated -- they're moved to the new
+# block rather than thrown away. Fetched structs point to NULL once they're
+# popped off or the vector is cleared, and everything fetched from the vector
+# points to NULL once it's freed.
+#
+# Everything a struct Array does, a vector does as well, over its first length
+# structs. That includes its MemoryView, which covers only its first length
+# structs and not the uninitialized capacity past them.
+#
+module Snow::CStruct::StructVectorBase
+
+  module Allocators ; end
+
+  include ::Snow::CStruct::StructArrayBase
+
+
+  # The capacity of a new vector, and the least capacity a vector grows to.
+  MIN_CAPACITY = 4
+
+
+  def self.included(vector_klass)
+    vector_klass.extend(Allocators)
+  end
+
+
+  # The number of structs the vector can hold before its block is reallocated.
+  def capacity
+    self.bytesize / self.class::BASE::SIZE
+  end
+
+
+  #
+  # call-seq:
+  #     push(*values) => self
+  #     push { |struct| ... } => self
+  #
+  # Appends structs to the end of the vector, growing it as needed. Each value
+  # is either a struct (or any Memory object at least as large as one), which
+  # is copied into the vector, or a Hash of member names to values, which are
+  # set on a zeroed struct. For members with a length greater than 1, a Hash
+  # value may be an Array of values for each element.
+  #
+  # If a block is given instead, a zeroed struct is appended and yielded to the
+  # block to initialize.
+  #
+  def push(*values)
+    if block_given?
+      raise ArgumentError, "Cannot push both values and a block" unless values.empty?
+      index = __append_zeroed__
+      yield fetch(index)
+      return self
+    end
+
+    __grow__(@length + values.length)
+    values.each { |value| append(value) }
+    self
+  end
+
+
+  #
+  # call-seq:
+  #     append(value) => self
+  #     self << value => self
+  #
+  # Appends a single struct or Hash to the vector. See #push.
+  #
+  def append(value)
+    index = @length
+    size = self.class::BASE::SIZE
+    case value
+    when ::Snow::Memory
+      __append__
+      begin
+        copy!(value, index * size, 0, size)
+      rescue
+        @length = index
+        raise
+      end
+    when Hash
+      # Not cached, since nothing outside the vector has seen it
+      struct = __build_wrapper__(__append_zeroed__)
+      begin
+        __assign_hash__(struct, value)
+      rescue
+        @length = index
+        raise
+      end
+    else
+      raise TypeError, "Expected a struct or Hash, got #{value.class}"
+    end
+    self
+  end
+  alias_method :<<, :append
+
+
+  #
+  # call-seq:
+  #     pop => struct or nil
+  #
+  # Removes the last struct from the vector and returns a copy of it, or nil if
+  # the vector is empty. Structs previously fetched at that index point to NULL
+  # afterward. Capacity is left as-is.
+  #
+  def pop
+    return nil if @length == 0
+    index = @length - 1
+    struct = self.class::BASE.new.copy!(self, 0, index * self.class::BASE::SIZE, self.class::BASE::SIZE)
+    __drop_cached__(index)
+    @length = index
+    struct
+  end
+
+
+  #
+  # call-seq:
+  #     reserve(min_capacity) => self
+  #
+  # Grows the vector's capacity to at least min_capacity structs if it's
+  # smaller than that. Unlike the growth from #push, this reserves exactly
+  # min_capacity structs.
+  #
+  def reserve(min_capacity)
+    min_capacity = min_capacity.to_i
+    __reallocate__(min_capacity) if min_capacity > capacity
+    self
+  end
+
+
+  #
+  # call-seq:
+  #     shrink_to_fit => self
+  #
+  # Shrinks the vector's capacity to its length (or one struct, if it's empty).
+  #
+  def shrink_to_fit
+    new_capacity = @length < 1 ? 1 : @length
+    __reallocate__(new_capacity) if new_capacity != capacity
+    self
+  end
+
+
+  #
+  # call-seq:
+  #     clear => self
+  #
+  # Removes every struct from the vector. Capacity is left as-is.
+  #
+  def clear
+    __free_cache__
+    @length = 0
+    self
+  end
+
+
+  #
+  # call-seq:
+  #     resize!(new_length) => self
+  #
+  # Sets the vector's length, growing its capacity if needed. New structs are
+  # zeroed and structs past the new length are dropped.
+  #
+  def resize!(new_length)
+    new_length = new_length.to_i
+    raise ArgumentError, "Length must not be negative" if new_length < 0
+    if new_length < @length
+      (new_length ... @length).each { |index| __drop_cached__(index) }
+    else
+      reserve(new_length) if new_length > capacity
+      size = self.class::BASE::SIZE
+      fill!(0, @length * size, (new_length - @length) * size) if new_length > @length
+    end
+    @length = new_length
+    self
+  end
+
+
+  def empty? # :nodoc:
+    @length == 0
+  end
+
+
+  def fetch(index) # :nodoc:
+    raise RangeError, "Attempt to access out-of-bounds index in #{self.class}" if index < 0 || @length <= index
+    @__cache__ ||= {}
+    @__cache__[index] ||= __build_wrapper__(index)
+  end
+  alias_method :[], :fetch
+
+
+  def store(index, data) # :nodoc:
+    raise TypeError, "Invalid value type, must be Memory, but got #{data.class}" if ! data.kind_of?(::Snow::Memory)
+    raise RangeError, "Attempt to access out-of-bounds index in #{self.class}" if index < 0 || @length <= index
+    size = self.class::BASE::SIZE
+    copy!(data, index * size, 0, size)
+    data
+  end
+  alias_method :[]=, :store
+
+
+  #
+  # Returns a new struct Array holding copies of the vector's structs. Raises
+  # a RangeError if the vector is empty, as arrays can't be.
+  #
+  def to_array
+    raise RangeError, "Cannot convert an empty #{self.class} to an array" if @length == 0
+    self.class::BASE::Array.new(@length).copy!(self, 0, 0, @length * self.class::BASE::SIZE)
+  end
+
+
+  #
+  # Returns a new SoA array holding copies of the vector's structs. Raises a
+  # RangeError if the vector is empty, as SoA arrays can't be.
+  #
+  def to_soa
+    raise RangeError, "Cannot convert an empty #{self.class} to an SoA array" if @length == 0
+    self.class::BASE::SoA.from_array(self)
+  end
+
+
+  def free! # :nodoc:
+    old_address, old_bytesize = self.address, self.bytesize
+    result = super
+    # With the block gone, this points every view into it to NULL
+    __rebase_views__(@__views__.keys, old_address, old_bytesize) if @__views__
+    @__views__ = nil
+    result
+  end
+
+
+  def dup # :nodoc:
+    copy = self.class.new(capacity)
+    copy.copy!(self, 0, 0, @length * self.class::BASE::SIZE) if @length > 0
+    copy.instance_variable_set(:@length, @length)
+    copy
+  end
+
+
+  private
+
+  # Unlike an array, a vector can be empty without being freed, in which case
+  # the reducers see no structs (member_sum is 0, the others nil).
+  def __member_reduce__(reducer, path) # :nodoc:
+    raise RuntimeError, "Attempt to access deallocated vector" if null?
+    type, offset = __member_scalar_path__(self.class::BASE, path)
+    __send__(reducer, type, offset, @length, self.class::BASE::SIZE)
+  end
+
+
+  # Reallocates the vector's block to hold new_capacity structs, moving every
+  # wrapper handed out by the vector to the new block.
+  def __reallocate__(new_capacity) # :nodoc:
+    base = self.class::BASE
+    old_address, old_bytesize = self.address, self.bytesize
+    realloc!(new_capacity * base::SIZE, base::ALIGNMENT, zero: false)
+    # Also run when resized in place, so views past a shrunken block are nulled
+    __rebase_views__(@__views__.keys, old_address, old_bytesize) if @__views__
+  end
+
+
+  #
+  # Element wrappers (including cursors) and, through the struct member
+  # getters, wrappers of their nested members are tracked weakly so they can be
+  # moved when the block is reallocated and nulled when it's freed.
+  #
+  def __build_wrapper__(index) # :nodoc:
+    wrapper = super
+    wrapper.instance_variable_set(:@__view_root__, self)
+    __track_view__(wrapper)
+  end
+
+
+  # Used by the extension to limit the vector's MemoryView to its length.
+  def __memory_view_bytesize__ # :nodoc:
+    @length * self.class::BASE::SIZE
+  end
+
+
+  def __track_view__(view) # :nodoc:
+    (@__views__ ||= ObjectSpace::WeakMap.new)[view] = view
+  end
+
+
+  # Grows the vector geometrically until it can hold min_capacity structs.
+  def __grow__(min_capacity) # :nodoc:
+    current = capacity
+    return if min_capacity <= current
+    new_capacity = current < MIN_CAPACITY ? MIN_CAPACITY : current * 2
+    new_capacity *= 2 while new_capacity < min_capacity
+    __reallocate__(new_capacity)
+  end
+
+
+  # Makes room for one more struct and returns its index.
+  def __append__ # :nodoc:
+    __grow__(@length + 1)
+    index = @length
+    @length += 1
+    index
+  end
+
+
+  def __append_zeroed__ # :nodoc:
+    index = __append__
+    size = self.class::BASE::SIZE
+    fill!(0, index * size, size)
+    index
+  end
+
+
+  def __assign_hash__(struct, hash) # :nodoc:
+    members = self.class::BASE::MEMBERS_HASH
+    hash.each { |name, value|
+      info = members.fetch(name.to_sym) {
+        raise ArgumentError, "#{self.class::BASE} has no member #{name}"
+      }
+      if info.length > 1 && value.kind_of?(::Array)
+        value.each_with_index { |element, index| struct[info.name, index] = element }
+      else
+        struct[info.name] = value
+      end
+    }
+    struct
+  end
+
+
+  def __drop_cached__(index) # :nodoc:
+    if @__cache__ && (entry = @__cache__.delete(index))
+      entry.free!
+      entry.remove_instance_variable(:@__base_memory__)
+    end
+  end
+
+end # module StructVectorBase
+
+
+
+module Snow::CStruct::StructVectorBase::Allocators
+
+  #
+  # call-seq:
+  #     new(capacity = 4) => Struct::Vector
+  #
+  # Allocates an empty vector with room for capacity structs. The default is
+  # also the capacity a smaller vector grows to first when pushed onto.
+  #
+  def new(capacity = ::Snow::CStruct::StructVectorBase::MIN_CAPACITY)
+    capacity = capacity.to_i
+    raise ArgumentError, "Capacity must be greater than zero" if capacity < 1
+    inst = __malloc__(capacity * self::BASE::SIZE, self::BASE::ALIGNMENT)
+    inst.instance_variable_set(:@length, 0)
+    inst.instance_variable_set(:@__cache__, nil)
+    inst
+  end
+
+
+  #
+  # Allocates a vector holding copies of the structs in a struct Array or
+  # vector of the same struct type, with a capacity of its length.
+  #
+  def from_array(array)
+    raise TypeError, "Expected a #{self::BASE} array, got #{array.class}" unless
+      array.kind_of?(::Snow::CStruct::StructArrayBase) && array.class::BASE == self::BASE
+    inst = new(array.length < 1 ? 1 : array.length)
+    inst.resize!(array.length)
+    inst.copy!(array, 0, 0, array.length * self::BASE::SIZE) if array.length > 0
+    inst
+  end
+
+
+  alias_method :[], :new
+
+end # module Allocators
@@ -34,6 +34,12 @@ class Snow::Memory
   #
   HAS_ALLOCA = self.respond_to?(:__alloca__)
 
+  #
+  # Whether or not __map__ is available (and ergo ::map and the methods for
+  # mapped blocks).
+  #
+  HAS_MMAP = self.respond_to?(:__map__)
+
   class <<self
     alias_method :new, :__wrap__
     alias_method :wrap, :__wrap__
@@ -46,19 +52,99 @@ class Snow::Memory
   end
 
 
+  if HAS_MMAP
+    #
+    # call-seq:
+    #     map(path, offset: 0, length: nil, mode: :read) => Memory
+    #     map(path, offset: 0, length: nil, mode: :read) { |memory| ... } => result of block
+    #
+    # Maps length bytes of a file, starting at offset, into memory and returns
+    # a Memory object that owns the mapping. If length is nil, the rest of the
+    # file is mapped. Nothing is read up front -- pages are read in as they're
+    # touched -- so this is much cheaper than reading a large file into a
+    # String and copying it into a block.
+    #
+    # Mode is one of :read, :read_write, or :private (copy-on-write). See
+    # ::__map__ for details. Blocks mapped with :read are read-only (see
+    # #readonly?).
+    #
+    # If a block is given, the mapped memory is yielded to it and unmapped
+    # once the block is done, and the result of the block is returned.
+    #
+    def self.map(path, offset: 0, length: nil, mode: :read)
+      memory = __map__(path, offset, length, mode)
+      return memory unless block_given?
+      begin
+        yield memory
+      ensure
+        memory.unmap! unless memory.null?
+      end
+    end
+  end
+
+
+  #
+  # call-seq:
+  #     from_pointer(pointer, size = nil, alignment = nil) => Memory
+  #
+  # Wraps the memory a Fiddle::Pointer or FFI::Pointer points to without
+  # copying it. If size is nil, the pointer's size is used, so it must be given
+  # for pointers without a known size (e.g., a Fiddle::Pointer made from a bare
+  # address or a plain FFI::Pointer). Raises an ArgumentError if it isn't.
   #
-  # The size in bytes of a memory block.
+  # Like ::wrap, the Memory object doesn't take ownership of the block. It does
+  # keep the pointer alive, though, so a block owned by the pointer (e.g., an
+  # FFI::MemoryPointer or a Fiddle::Pointer with a free function) isn't freed
+  # while the Memory object is in use.
   #
-  def bytesize
-    @__bytesize__
+  def self.from_pointer(pointer, size = nil, alignment = nil)
+    address = pointer.respond_to?(:address) ? pointer.address : pointer.to_i
+    if size.nil?
+      size = pointer.size
+      # Fiddle::Pointers without a size report 0, and FFI::Pointers without a
+      # size limit report LONG_MAX
+      if size == 0 || (pointer.respond_to?(:size_limit?) && !pointer.size_limit?)
+        raise ArgumentError, "#{pointer.class} has no known size -- give a size"
+      end
+    end
+    memory = __wrap__(address, size, alignment)
+    memory.instance_variable_set(:@__base_memory__, pointer)
+    memory
+  end
+
+
+  #
+  # call-seq:
+  #     to_fiddle_pointer => Fiddle::Pointer
+  #
+  # Returns a Fiddle::Pointer to the receiver's block with the same size. The
+  # pointer shares the block rather than copying it and keeps the receiver
+  # alive, but doesn't own the block, so it's only valid until the receiver is
+  # freed or reallocated.
+  #
+  def to_fiddle_pointer
+    require 'fiddle'
+    raise RuntimeError, "Cannot get a pointer to a null block" if null?
+    pointer = ::Fiddle::Pointer.new(self.address, self.bytesize)
+    pointer.instance_variable_set(:@__base_memory__, self)
+    pointer
   end
 
 
   #
-  # The alignment in bytes of a memory block.
+  # call-seq:
+  #     to_ffi_pointer => FFI::Pointer
+  #
+  # Returns an FFI::Pointer to the receiver's block, bounded to its size. As
+  # with #to_fiddle_pointer, the pointer shares the block, keeps the receiver
+  # alive, and is only valid until the receiver is freed or reallocated.
   #
-  def alignment
-    @__alignment__
+  def to_ffi_pointer
+    require 'ffi'
+    raise RuntimeError, "Cannot get a pointer to a null block" if null?
+    pointer = ::FFI::Pointer.new(:uint8, self.address).slice(0, self.bytesize)
+    pointer.instance_variable_set(:@__base_memory__, self)
+    pointer
   end
 
 
@@ -75,6 +161,7 @@ class Snow::Memory
   # properties -- that is, whether they have the address and bytesize. If true,
   # the objects refer to teh same block of memory. If false, they might still
   # overlap, refer to different chunks of memory, one might be null, etc.
+  # To compare the blocks' contents, use #eql_content?.
   #
   def ==(other)
     return false unless other
@@ -101,7 +188,7 @@ class Snow::Memory
   # copies the receiver's data to the new block; and returns the new block.
   #
   def dup
-    new_self = self.class.__malloc__(self.bytesize, self.alignment)
+    new_self = self.class.__malloc__(self.bytesize, self.alignment, zero: false)
     new_self.copy!(self, 0, 0, self.bytesize)
   end
 
@@ -0,0 +1,66 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'test_helper'
+
+ArenaVec3  = Snow::CStruct[:ArenaVec3, 'x: float; y: float; z: float']
+ArenaPoint = Snow::CStruct[:ArenaPoint, 'pos: ArenaVec3; id: uint32_t']
+
+
+class ArenaTest < Minitest::Test
+
+  def setup
+    @arena = Snow::Arena.new
+    @memory = @arena.alloc(16)
+    @memory.fill!(?a.ord)
+  end
+
+
+  def test_release_raises_while_viewed
+    view = @memory.view
+    assert_raises(RuntimeError) { @arena.release! }
+    assert_raises(RuntimeError) { @arena.reset! }
+    assert_equal ?a * 16, view
+    refute_equal 0, @memory.address
+  end
+
+
+  def test_release_invalidates_unviewed_memory
+    @arena.release!
+    assert_equal 0, @memory.address
+  end
+
+
+
+  def test_reset_nulls_nested_members
+    point = @arena.struct(ArenaPoint)
+    pos = point.pos
+    pos.x = 1.0
+    @arena.reset!
+    assert pos.null?
+    @arena.struct(ArenaPoint) { |other| other.pos.x = 99.0 }
+    assert_equal 0, pos.address
+  end
+
+
+  def test_release_nulls_nested_members_of_array_elements
+    points = @arena.array(ArenaPoint, 4)
+    element_pos = points[1].pos
+    cursor_pos = nil
+    points.cursor_mode = true
+    points.each { |point| cursor_pos = point.pos }
+    @arena.release!
+    assert element_pos.null?
+    assert cursor_pos.null?
+  end
+
+
+  def test_reset_raises_while_nested_member_viewed
+    pos = @arena.struct(ArenaPoint).pos
+    view = pos.view
+    assert_raises(RuntimeError) { @arena.reset! }
+    assert_equal 12, view.bytesize
+  end
+
+end
@@ -0,0 +1,67 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'test_helper'
+require 'tempfile'
+
+
+class MemoryTest < Minitest::Test
+
+  def setup
+    @memory = Snow::Memory.malloc(64)
+  end
+
+
+  def test_view_pins_block
+    view = @memory.view
+    assert_raises(RuntimeError) { @memory.free! }
+    assert_raises(RuntimeError) { @memory.realloc!(128) }
+    assert_equal 64, view.bytesize
+  end
+
+
+  def test_free_after_view_is_collected
+    # Take the view on another thread so no stack the GC scans refers to it
+    Thread.new { @memory.view.bytesize }.join
+    GC.start
+    @memory.realloc!(128)
+    @memory.free!
+    assert @memory.null?
+  end
+
+
+  def test_zero_length_operations_at_end
+    other = Snow::Memory.malloc(8)
+    @memory.fill!(1, 64, 0)
+    assert_equal 0, @memory.compare(other, 64, 8, 0)
+    assert_raises(RangeError) { @memory.fill!(1, 65, 0) }
+  end
+
+
+  def test_from_pointer_requires_a_known_size
+    require 'fiddle'
+    pointer = Fiddle::Pointer.new(@memory.address)
+    assert_raises(ArgumentError) { Snow::Memory.from_pointer(pointer) }
+    assert_equal 16, Snow::Memory.from_pointer(pointer, 16).bytesize
+  end
+
+
+  if Snow::Memory::HAS_MMAP
+    def test_read_mapping_rejects_writes
+      Tempfile.create('snow-data') { |file|
+        file.write("\x01" * 64)
+        file.flush
+        mapped = Snow::Memory.__map__(file.path, 0, nil, :read)
+        assert mapped.readonly?
+        refute mapped.frozen?
+        assert_raises(RuntimeError) { mapped.set_uint8_t(0, 2) }
+        assert_raises(RuntimeError) { mapped.fill!(0) }
+        assert_raises(RuntimeError) { mapped.copy!(@memory, 0, 0, 8) }
+        assert_equal 1, mapped.get_uint8_t(63)
+        mapped.unmap!
+      }
+    end
+  end
+
+end
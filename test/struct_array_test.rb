@@ -0,0 +1,46 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'test_helper'
+
+ArrayVec3  = Snow::CStruct[:ArrayVec3, 'x: float; y: float; z: float']
+ArrayShape = Snow::CStruct[:ArrayShape, 'pos: ArrayVec3[4]; id: uint32_t']
+
+
+class StructArrayTest < Minitest::Test
+
+  def setup
+    @shapes = ArrayShape[3]
+    @shapes.each_with_index { |shape, index|
+      4.times { |corner| shape.pos(corner).x = Float(index * 10 + corner) }
+      shape.id = 3 - index
+    }
+  end
+
+
+  def test_reducers_read_indexed_member_elements
+    assert_equal 0.0 + 10.0 + 20.0, @shapes.member_sum(:pos, 0, :x)
+    assert_equal 3.0 + 13.0 + 23.0, @shapes.member_sum(:pos, 3, :x)
+    assert_equal 21.0, @shapes.member_max(:pos, 1, :x)
+  end
+
+  def test_reducers_reject_member_path_without_index
+    [:member_sum, :member_min, :member_max, :member_mean].each { |reducer|
+      assert_raises(ArgumentError) { @shapes.__send__(reducer, :pos, :x) }
+    }
+    assert_raises(ArgumentError) { @shapes.member_dot([:pos, :x], @shapes) }
+  end
+
+  def test_sort_by_indexed_member
+    assert_equal [2, 1, 0], @shapes.argsort([:pos, 2, :x], descending: true)
+    @shapes.sort_by_member!([:pos, 2, :x], descending: true)
+    assert_equal [1, 2, 3], @shapes.to_a.map(&:id)
+  end
+
+  def test_sort_rejects_member_path_without_index
+    assert_raises(ArgumentError) { @shapes.sort_by_member!([:pos, :x]) }
+    assert_raises(ArgumentError) { @shapes.argsort([:pos, :x]) }
+  end
+
+end
@@ -0,0 +1,6 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'minitest/autorun'
+require 'snow-data'
@@ -0,0 +1,95 @@
+# This file is part of ruby-snowdata.
+# Copyright (c) 2013 Noel Raymond Cower. All rights reserved.
+# See COPYING for license details.
+
+require 'test_helper'
+
+begin
+  require 'fiddle'
+rescue LoadError
+
+  if defined?(::Fiddle::MemoryView)
+    def test_memory_view_covers_length
+      @vector.reserve(8)
+      assert_operator @vector.capacity, :>, @vector.length
+      ::Fiddle::MemoryView.export(@vector) { |view|
+        assert_equal @vector.length * TestVertex::SIZE, view.byte_size
+        assert_equal [@vector.length], view.shape
+      }
+    end
+  end
+
+end
+
+TestVec3   = Snow::CStruct[:TestVec3, 'x: float; y: float; z: float']
+TestVertex = Snow::CStruct[:TestVertex, 'position: TestVec3; id: uint32_t']
+
+
+class VectorTest < Minitest::Test
+
+  def setup
+    @vector = TestVertex::Vector.new(1)
+    @vector.push { |vertex|
+      vertex.position.x = 1.5
+      vertex.id = 7
+    }
+  end
+
+
+  def grow(vector)
+    address = vector.address
+    100.times { |index| vector.push(id: index) }
+    refute_equal address, vector.address, "the block should have moved"
+  end
+
+
+  def test_nested_member_survives_growth
+    position = @vector[0].position
+    grow(@vector)
+    assert_equal 1.5, position.x
+    position.y = 2.0
+    assert_equal 2.0, @vector[0].position.y
+  end
+
+
+  def test_cursor_nested_member_survives_growth
+    position = nil
+    @vector.cursor_mode = true
+    @vector.each { |vertex| position = vertex.position }
+    grow(@vector)
+    assert_equal 1.5, position.x
+  end
+
+
+  def test_free_nulls_nested_members
+    vertex = @vector[0]
+    position = vertex.position
+    @vector.free!
+    assert_equal 0, vertex.address
+    assert_equal 0, position.address
+  end
+
+
+  def test_reducers_on_empty_vector
+    empty = TestVertex::Vector.new(1)
+    assert_equal 0, empty.member_sum(:id)
+    assert_nil empty.member_min(:position, :x)
+    assert_nil empty.member_mean(:id)
+    assert_raises(RangeError) { empty.to_soa }
+    empty.free!
+    assert_raises(RuntimeError) { empty.member_sum(:id) }
+  end
+
+
+  if defined?(::Fiddle::MemoryView)
+    def test_memory_view_covers_length
+      @vector.reserve(8)
+      assert_operator @vector.capacity, :>, @vector.length
+      ::Fiddle::MemoryView.export(@vector) { |view|
+        assert_equal @vector.length * TestVertex::SIZE, view.byte_size
+        assert_equal [@vector.length], view.shape
+      }
+    end
+  end
+
+end